@@ -0,0 +1,245 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "parallel.hpp"
+
+namespace linmath {
+
+template <typename R>
+class task;
+
+namespace detail {
+
+template <typename R>
+class task_state final {
+  std::mutex m_mutex;
+  std::condition_variable m_cv;
+  std::optional<R> m_value;
+  std::exception_ptr m_error;
+  bool m_done = false;
+  std::vector<std::function<void()>> m_continuations;
+
+ public:
+  // fn runs on the completing thread, or right away if already complete
+  void on_complete(std::function<void()> fn) {
+    {
+      std::lock_guard<std::mutex> lock{m_mutex};
+      if (!m_done) {
+        m_continuations.push_back(std::move(fn));
+        return;
+      }
+    }
+    fn();
+  }
+
+  template <typename F>
+  void fulfill(F&& fn) {
+    try {
+      m_value.emplace(fn());
+    } catch (...) {
+      m_error = std::current_exception();
+    }
+
+    std::vector<std::function<void()>> ready;
+    {
+      std::lock_guard<std::mutex> lock{m_mutex};
+      m_done = true;
+      ready.swap(m_continuations);
+    }
+    m_cv.notify_all();
+    for (auto& cont : ready)
+      cont();
+  }
+
+  void wait() {
+    std::unique_lock<std::mutex> lock{m_mutex};
+    m_cv.wait(lock, [this] { return m_done; });
+  }
+
+  bool ready() {
+    std::lock_guard<std::mutex> lock{m_mutex};
+    return m_done;
+  }
+
+  const R& get() {
+    wait();
+    if (m_error)
+      std::rethrow_exception(m_error);
+    return *m_value;
+  }
+};
+
+struct task_access {
+  template <typename R>
+  static const std::shared_ptr<task_state<R>>& state(const task<R>& t) {
+    return t.m_state;
+  }
+};
+
+}  // namespace detail
+
+// Handle to a value computed on the library thread pool. Copies share the
+// same result; get() blocks until it is available and rethrows any
+// exception raised while computing it or one of its inputs.
+template <typename R>
+class task final {
+  std::shared_ptr<detail::task_state<R>> m_state;
+
+  friend struct detail::task_access;
+
+ public:
+  task() = default;
+  explicit task(std::shared_ptr<detail::task_state<R>> state)
+      : m_state{std::move(state)} {}
+
+  bool valid() const noexcept { return static_cast<bool>(m_state); }
+
+  bool ready() const {
+    if (!valid())
+      throw std::runtime_error("Task has no state");
+    return m_state->ready();
+  }
+
+  void wait() const {
+    if (!valid())
+      throw std::runtime_error("Task has no state");
+    m_state->wait();
+  }
+
+  const R& get() const {
+    if (!valid())
+      throw std::runtime_error("Task has no state");
+    return m_state->get();
+  }
+
+  template <typename F>
+  auto then(F&& fn) const;
+};
+
+template <typename R>
+task<std::decay_t<R>> make_ready_task(R&& value) {
+  auto state = std::make_shared<detail::task_state<std::decay_t<R>>>();
+  state->fulfill([&value]() -> std::decay_t<R> {
+    return std::forward<R>(value);
+  });
+  return task<std::decay_t<R>>{std::move(state)};
+}
+
+// Schedules fn(deps.get()...) on the pool once every dependency has
+// completed. Nothing blocks while waiting: the last dependency to finish
+// submits the job, so independent branches of the graph run concurrently.
+template <typename F, typename... Deps>
+auto async_invoke(F&& fn, const task<Deps>&... deps) {
+  using ret_t = std::decay_t<std::invoke_result_t<F&, const Deps&...>>;
+  using state_t = detail::task_state<ret_t>;
+
+  struct job {
+    std::shared_ptr<state_t> state;
+    std::decay_t<F> fn;
+    std::tuple<task<Deps>...> inputs;
+    std::atomic<std::size_t> pending;
+
+    job(std::shared_ptr<state_t> state_, F&& fn_, const task<Deps>&... deps_)
+        : state{std::move(state_)},
+          fn{std::forward<F>(fn_)},
+          inputs{deps_...},
+          pending{sizeof...(Deps) + 1} {}
+
+    void run() {
+      state->fulfill([this]() -> ret_t {
+        return std::apply(
+            [this](const auto&... in) { return fn(in.get()...); }, inputs);
+      });
+    }
+  };
+
+  auto state = std::make_shared<state_t>();
+  auto shared_job =
+      std::make_shared<job>(state, std::forward<F>(fn), deps...);
+  auto arrive = [shared_job]() {
+    if (shared_job->pending.fetch_sub(1) == 1)
+      parallel::default_pool().submit([shared_job] { shared_job->run(); });
+  };
+
+  (detail::task_access::state(deps)->on_complete(arrive), ...);
+  arrive();
+  return task<ret_t>{std::move(state)};
+}
+
+template <typename R>
+template <typename F>
+auto task<R>::then(F&& fn) const {
+  return async_invoke(std::forward<F>(fn), *this);
+}
+
+namespace detail {
+
+template <typename M>
+struct is_task : std::false_type {};
+template <typename R>
+struct is_task<task<R>> : std::true_type {};
+
+template <typename M>
+task<M> as_task(const task<M>& t) {
+  return t;
+}
+
+// Plain matrices are copied into a completed task
+template <typename M>
+task<std::decay_t<M>> as_task(M&& matr)
+    requires(!is_task<std::decay_t<M>>::value) {
+  return make_ready_task(std::forward<M>(matr));
+}
+
+}  // namespace detail
+
+template <typename L, typename R>
+auto async_multiply(L&& lhs, R&& rhs) {
+  return async_invoke([](const auto& l, const auto& r) { return l * r; },
+                      detail::as_task(std::forward<L>(lhs)),
+                      detail::as_task(std::forward<R>(rhs)));
+}
+
+template <typename L, typename R>
+auto async_add(L&& lhs, R&& rhs) {
+  return async_invoke([](const auto& l, const auto& r) { return l + r; },
+                      detail::as_task(std::forward<L>(lhs)),
+                      detail::as_task(std::forward<R>(rhs)));
+}
+
+template <typename L, typename R>
+auto async_subtract(L&& lhs, R&& rhs) {
+  return async_invoke([](const auto& l, const auto& r) { return l - r; },
+                      detail::as_task(std::forward<L>(lhs)),
+                      detail::as_task(std::forward<R>(rhs)));
+}
+
+template <typename M, typename T>
+auto async_scale(M&& matr, T value) {
+  return async_invoke([value](const auto& m) { return m * value; },
+                      detail::as_task(std::forward<M>(matr)));
+}
+
+template <typename M>
+auto async_transpose(M&& matr) {
+  return async_invoke(
+      [](const auto& m) {
+        auto ret = m;
+        ret.transpose();
+        return ret;
+      },
+      detail::as_task(std::forward<M>(matr)));
+}
+
+}  // namespace linmath
@@ -0,0 +1,201 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <initializer_list>
+#include <limits>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "kernels.hpp"
+#include "quantized.hpp"
+#include "shell_matrix.hpp"
+#include "simd.hpp"
+#include "tuning_cache.hpp"
+
+namespace linmath {
+
+struct autotune_settings {
+  // Edge of the square matrices the kernels are timed on
+  std::size_t size = 512;
+  // Every candidate is timed this many times and its best run counts
+  int repeats = 3;
+  // A candidate replaces the current value only when it is at least this
+  // much faster, so timing noise does not churn the cache file
+  double min_gain = 0.05;
+};
+
+namespace detail {
+
+template <typename F>
+double best_time(int repeats, F&& run) {
+  double best = std::numeric_limits<double>::max();
+  for (int rep = 0; rep < std::max(repeats, 1); ++rep) {
+    auto start = std::chrono::steady_clock::now();
+    run();
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    best = std::min(best, elapsed.count());
+  }
+  return best;
+}
+
+// Times run() with field set to the current value and to every candidate,
+// then leaves field at the fastest one
+template <typename V, typename F>
+void tune_field(V& field,
+                std::type_identity_t<std::initializer_list<V>> candidates,
+                const autotune_settings& settings, F&& run) {
+  V best = field;
+  double best_t = best_time(settings.repeats, run);
+  for (V cand : candidates) {
+    if (cand == best)
+      continue;
+    field = cand;
+    double t = best_time(settings.repeats, run);
+    if (t < best_t * (1.0 - settings.min_gain)) {
+      best = cand;
+      best_t = t;
+    }
+  }
+  field = best;
+}
+
+inline float bench_value(std::size_t idx) {
+  return static_cast<float>(idx % 17) * 0.25f - 2.0f;
+}
+
+}  // namespace detail
+
+// Microbenchmarks the multiply, transpose, fill and elementwise kernels
+// over candidate parameters, one parameter at a time, and makes the
+// winners current. Must not run concurrently with other kernels.
+inline kernels::tuning autotune(const autotune_settings& settings = {}) {
+  kernels::tuning& cur = kernels::params();
+  const std::size_t sz = std::max<std::size_t>(settings.size, 16);
+
+  shell_matrix<float> a{sz, sz};
+  shell_matrix<float> b{sz, sz};
+  for (std::size_t idx = 0; idx != sz * sz; ++idx) {
+    a.data()[idx] = detail::bench_value(idx);
+    b.data()[idx] = detail::bench_value(idx * 7 + 3);
+  }
+  shell_matrix<float> c{sz, sz};
+
+  detail::tune_field(cur.gemm_block, {32, 64, 128, 256, 512}, settings, [&] {
+    kernels::fill(c.data(), sz, sz, 0.0f);
+    kernels::gemm(std::as_const(a).data(), std::as_const(b).data(), c.data(),
+                  sz, sz, sz);
+  });
+
+  // Small products are where the threshold decides
+  detail::tune_field(
+      cur.gemm_parallel_threshold,
+      {std::size_t{1} << 12, std::size_t{1} << 14, std::size_t{1} << 16,
+       std::size_t{1} << 18, std::size_t{1} << 20},
+      settings, [&] {
+        for (std::size_t n = 8; n <= sz / 2; n *= 2)
+          for (int rep = 0; rep != 4; ++rep) {
+            kernels::fill(c.data(), n, n, 0.0f);
+            kernels::gemm(std::as_const(a).data(), std::as_const(b).data(),
+                          c.data(), n, n, n);
+          }
+      });
+
+  detail::tune_field(cur.transpose_block, {8, 16, 32, 64, 128}, settings,
+                     [&] {
+                       kernels::transpose(std::as_const(a).data(), c.data(),
+                                          sz / 2, sz * 2);
+                     });
+
+  auto sweep = [sz](auto&& kernel) {
+    for (std::size_t rows = 16; rows <= sz * sz / 64; rows *= 4)
+      kernel(rows);
+  };
+  detail::tune_field(
+      cur.fill_parallel_threshold,
+      {std::size_t{1} << 14, std::size_t{1} << 16, std::size_t{1} << 18,
+       std::size_t{1} << 20, std::size_t{1} << 22},
+      settings, [&] {
+        sweep([&](std::size_t rows) {
+          kernels::fill(c.data(), rows, 64, 1.0f);
+        });
+      });
+  detail::tune_field(
+      cur.map_parallel_threshold,
+      {std::size_t{1} << 12, std::size_t{1} << 14, std::size_t{1} << 15,
+       std::size_t{1} << 16, std::size_t{1} << 18},
+      settings, [&] {
+        sweep([&](std::size_t rows) {
+          kernels::map(
+              c.data(), rows, 64, [](float x, float y) { return x * y + x; },
+              std::as_const(a).data(), std::as_const(b).data());
+        });
+      });
+
+  // Wider is not always faster, e.g. when 512-bit units downclock
+  const std::size_t qn = std::max<std::size_t>(sz / 2, 8);
+  std::vector<std::int8_t> qa(qn * qn);
+  std::vector<std::int8_t> qb(qn * qn);
+  for (std::size_t idx = 0; idx != qa.size(); ++idx) {
+    qa[idx] = static_cast<std::int8_t>(idx % 255 - 127);
+    qb[idx] = static_cast<std::int8_t>((idx * 5) % 255 - 127);
+  }
+  std::vector<std::int32_t> qc(qn * qn);
+  std::vector<simd::isa> levels;
+  for (auto level :
+       {simd::isa::scalar, simd::isa::avx2, simd::isa::avx512_vnni})
+    if (simd::supports(level))
+      levels.push_back(level);
+  simd::isa best_level = cur.quantized_isa;
+  double best_t = std::numeric_limits<double>::max();
+  for (simd::isa level : levels) {
+    double t = detail::best_time(settings.repeats, [&] {
+      kernels::gemm_quantized(qa.data(), qb.data(), qc.data(), qn, qn, qn,
+                              level);
+    });
+    if (level == cur.quantized_isa)
+      t *= 1.0 - settings.min_gain;
+    if (t < best_t) {
+      best_t = t;
+      best_level = level;
+    }
+  }
+  cur.quantized_isa = best_level;
+
+  return cur;
+}
+
+// Loads the cached parameters, tuning and caching them first if this CPU
+// model has no entry yet
+inline void ensure_tuned(const std::string& path = tuning_path(),
+                         const autotune_settings& settings = {}) {
+  if (load_tuning(path))
+    return;
+  autotune(settings);
+  save_tuning(path);
+}
+
+namespace detail {
+
+// With LINMATH_AUTOTUNE set, programs that include this header tune hosts
+// without a cached entry before main(). Failures keep the current values.
+inline bool autotune_at_startup() {
+  if (!std::getenv("LINMATH_AUTOTUNE") || std::getenv("LINMATH_NO_TUNING"))
+    return false;
+  try {
+    ensure_tuned();
+    return true;
+  } catch (...) {
+    return false;
+  }
+}
+
+inline const bool tuned_at_startup = autotune_at_startup();
+
+}  // namespace detail
+
+}  // namespace linmath
@@ -0,0 +1,314 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include "kernels.hpp"
+#include "parallel.hpp"
+#include "shell_matrix.hpp"
+#include "vector.hpp"
+
+namespace linmath {
+
+// Boolean matrix with 64 entries per word. Every row starts on a word
+// boundary; bits past n_cols in the last word of a row are always zero.
+class bit_matrix final {
+  std::size_t n_rows = 0;
+  std::size_t n_cols = 0;
+  std::size_t n_words = 0;  // per row
+
+  containers::vector<std::uint64_t> m_words;
+
+  static constexpr std::size_t word_bits = 64;
+
+ public:
+  bit_matrix(std::size_t rows, std::size_t cols)
+      : n_rows{rows},
+        n_cols{cols},
+        n_words{(cols + word_bits - 1) / word_bits},
+        m_words(rows * ((cols + word_bits - 1) / word_bits), 0) {}
+
+  static bit_matrix identity(std::size_t sz) {
+    bit_matrix ret{sz, sz};
+    for (std::size_t i = 0; i != sz; ++i)
+      ret.set(i, i);
+    return ret;
+  }
+
+  // Nonzero entries become true
+  template <typename T, typename B>
+  static bit_matrix from_dense(const shell_matrix<T, B>& dense) {
+    bit_matrix ret{dense.nrows(), dense.ncols()};
+    for (std::size_t i = 0; i != ret.n_rows; ++i)
+      for (std::size_t j = 0; j != ret.n_cols; ++j)
+        if (dense[i][j] != T{})
+          ret.set(i, j);
+    return ret;
+  }
+
+  template <typename T = int>
+  shell_matrix<T> to_dense() const {
+    shell_matrix<T> ret{n_rows, n_cols};
+    for (std::size_t i = 0; i != n_rows; ++i)
+      for (std::size_t j = 0; j != n_cols; ++j)
+        if (get(i, j))
+          ret[i][j] = T{1};
+    return ret;
+  }
+
+  bool get(std::size_t i, std::size_t j) const {
+    return (row(i)[j / word_bits] >> (j % word_bits)) & 1;
+  }
+
+  void set(std::size_t i, std::size_t j, bool value = true) {
+    std::uint64_t mask = std::uint64_t{1} << (j % word_bits);
+    std::uint64_t& word = row(i)[j / word_bits];
+    word = value ? (word | mask) : (word & ~mask);
+  }
+
+  void flip(std::size_t i, std::size_t j) {
+    row(i)[j / word_bits] ^= std::uint64_t{1} << (j % word_bits);
+  }
+
+  std::uint64_t* row(std::size_t i) { return m_words.data() + i * n_words; }
+  const std::uint64_t* row(std::size_t i) const {
+    return m_words.data() + i * n_words;
+  }
+
+  void swap_rows(std::size_t lhs, std::size_t rhs) {
+    std::swap_ranges(row(lhs), row(lhs) + n_words, row(rhs));
+  }
+
+  // Number of true entries
+  std::size_t count() const {
+    std::size_t ret = 0;
+    for (std::size_t idx = 0; idx != m_words.size(); ++idx)
+      ret += std::popcount(m_words[idx]);
+    return ret;
+  }
+
+ private:
+  template <typename Op>
+  bit_matrix& combine(const bit_matrix& rhs, Op op) {
+    if (n_rows != rhs.n_rows || n_cols != rhs.n_cols)
+      throw std::runtime_error("Unsuitable matrix sizes");
+    std::uint64_t* dst = m_words.data();
+    const std::uint64_t* src = rhs.m_words.data();
+    for (std::size_t idx = 0; idx != m_words.size(); ++idx)
+      dst[idx] = op(dst[idx], src[idx]);
+    return *this;
+  }
+
+ public:
+  bit_matrix& operator|=(const bit_matrix& rhs) {
+    return combine(rhs, [](std::uint64_t a, std::uint64_t b) { return a | b; });
+  }
+  bit_matrix& operator&=(const bit_matrix& rhs) {
+    return combine(rhs, [](std::uint64_t a, std::uint64_t b) { return a & b; });
+  }
+  bit_matrix& operator^=(const bit_matrix& rhs) {
+    return combine(rhs, [](std::uint64_t a, std::uint64_t b) { return a ^ b; });
+  }
+
+  bool operator==(const bit_matrix& rhs) const {
+    return n_rows == rhs.n_rows && n_cols == rhs.n_cols &&
+           std::equal(m_words.begin(), m_words.end(), rhs.m_words.begin());
+  }
+
+  // Reduces to reduced row echelon form over GF(2), returns the rank
+  std::size_t eliminate_gf2();
+
+  std::size_t rank_gf2() const {
+    bit_matrix tmp{*this};
+    return tmp.eliminate_gf2();
+  }
+
+  // Warshall: (i, j) is set in the result when j is reachable from i by a
+  // path of one or more edges. OR in identity() for reflexive closure.
+  bit_matrix transitive_closure() const;
+
+  void dump(std::ostream& os) const {
+    os << "n_rows = " << n_rows << '\n';
+    os << "n_cols = " << n_cols << '\n';
+    for (std::size_t i = 0; i != n_rows; ++i) {
+      for (std::size_t j = 0; j != n_cols; ++j)
+        os << (get(i, j) ? '1' : '0');
+      os << '\n';
+    }
+  }
+
+  std::size_t nrows() const { return n_rows; }
+  std::size_t ncols() const { return n_cols; }
+  std::size_t words_per_row() const { return n_words; }
+  bool square() const { return n_rows == n_cols; }
+};
+
+namespace kernels {
+namespace detail {
+
+// Four Russians (M4RM) product C = A * B with rows of C combined by op
+// (OR for the boolean semiring, XOR for GF(2)). For every 64 rows of B
+// eight tables of all 256 byte-indexed combinations are built, then each
+// row of C takes one table lookup per byte of the matching word of A.
+template <typename Op>
+void m4rm(const bit_matrix& a, const bit_matrix& b, bit_matrix& c, Op op) {
+  constexpr std::size_t n_tables = 8;
+  constexpr std::size_t table_size = 256;
+  const std::size_t words = b.words_per_row();
+  const std::size_t n_inner = a.ncols();
+  std::vector<std::uint64_t> tables(n_tables * table_size * words);
+
+  for (std::size_t base = 0; base < n_inner; base += 64) {
+    const std::size_t word_idx = base / 64;
+    parallel::for_each_chunk(n_tables, 1, [&](std::size_t t_frst,
+                                              std::size_t t_lst) {
+      for (std::size_t t = t_frst; t != t_lst; ++t) {
+        std::uint64_t* table = tables.data() + t * table_size * words;
+        std::fill_n(table, words, 0);
+        for (std::size_t mask = 1; mask != table_size; ++mask) {
+          // table[mask] = table[mask without lowest bit] op B[row of it]
+          const std::size_t low = std::countr_zero(mask);
+          const std::size_t b_row = base + t * 8 + low;
+          const std::uint64_t* prev = table + (mask & (mask - 1)) * words;
+          std::uint64_t* cur = table + mask * words;
+          if (b_row >= n_inner) {
+            std::copy_n(prev, words, cur);
+            continue;
+          }
+          const std::uint64_t* src = b.row(b_row);
+          for (std::size_t w = 0; w != words; ++w)
+            cur[w] = op(prev[w], src[w]);
+        }
+      }
+    });
+
+    split_rows(a.nrows(), n_tables * words, [&](std::size_t row_frst,
+                                                std::size_t row_lst) {
+      for (std::size_t i = row_frst; i != row_lst; ++i) {
+        const std::uint64_t bits = a.row(i)[word_idx];
+        if (bits == 0)
+          continue;
+        std::uint64_t* dst = c.row(i);
+        for (std::size_t t = 0; t != n_tables; ++t) {
+          const std::size_t byte = (bits >> (8 * t)) & 0xff;
+          if (byte == 0)
+            continue;
+          const std::uint64_t* src =
+              tables.data() + (t * table_size + byte) * words;
+          for (std::size_t w = 0; w != words; ++w)
+            dst[w] = op(dst[w], src[w]);
+        }
+      }
+    });
+  }
+}
+
+// Small products: every set bit of A combines one row of B into C
+template <typename Op>
+void bit_multiply_rows(const bit_matrix& a, const bit_matrix& b,
+                       bit_matrix& c, Op op) {
+  const std::size_t words = b.words_per_row();
+  for (std::size_t i = 0; i != a.nrows(); ++i) {
+    std::uint64_t* dst = c.row(i);
+    const std::uint64_t* a_row = a.row(i);
+    for (std::size_t w = 0; w != a.words_per_row(); ++w)
+      for (std::uint64_t bits = a_row[w]; bits; bits &= bits - 1) {
+        const std::uint64_t* src = b.row(w * 64 + std::countr_zero(bits));
+        for (std::size_t v = 0; v != words; ++v)
+          dst[v] = op(dst[v], src[v]);
+      }
+  }
+}
+
+// Below this many rows in A the tables cost more than they save
+static constexpr std::size_t m4rm_min_rows = 64;
+
+template <typename Op>
+bit_matrix bit_multiply(const bit_matrix& a, const bit_matrix& b, Op op) {
+  if (a.ncols() != b.nrows())
+    throw std::runtime_error("Unsuitable matrix sizes");
+  bit_matrix c{a.nrows(), b.ncols()};
+  if (a.nrows() < m4rm_min_rows)
+    bit_multiply_rows(a, b, c, op);
+  else
+    m4rm(a, b, c, op);
+  return c;
+}
+
+}  // namespace detail
+}  // namespace kernels
+
+// Boolean semiring product: (i, j) = OR_k a(i, k) AND b(k, j)
+inline bit_matrix bool_multiply(const bit_matrix& a, const bit_matrix& b) {
+  return kernels::detail::bit_multiply(
+      a, b, [](std::uint64_t x, std::uint64_t y) { return x | y; });
+}
+
+// Product over GF(2): (i, j) = XOR_k a(i, k) AND b(k, j)
+inline bit_matrix gf2_multiply(const bit_matrix& a, const bit_matrix& b) {
+  return kernels::detail::bit_multiply(
+      a, b, [](std::uint64_t x, std::uint64_t y) { return x ^ y; });
+}
+
+inline std::size_t bit_matrix::eliminate_gf2() {
+  std::size_t rank = 0;
+  for (std::size_t col = 0; col != n_cols && rank != n_rows; ++col) {
+    const std::size_t word = col / word_bits;
+    const std::uint64_t mask = std::uint64_t{1} << (col % word_bits);
+
+    std::size_t piv = rank;
+    while (piv != n_rows && !(row(piv)[word] & mask))
+      ++piv;
+    if (piv == n_rows)
+      continue;
+    swap_rows(piv, rank);
+
+    // Words left of the pivot are zero in the pivot row
+    const std::uint64_t* pivot_row = row(rank);
+    const std::size_t row_work = n_words - word;
+    kernels::detail::split_rows(
+        n_rows, row_work, [&](std::size_t row_frst, std::size_t row_lst) {
+          for (std::size_t i = row_frst; i != row_lst; ++i) {
+            std::uint64_t* cur = row(i);
+            if (i == rank || !(cur[word] & mask))
+              continue;
+            for (std::size_t w = word; w != n_words; ++w)
+              cur[w] ^= pivot_row[w];
+          }
+        });
+    ++rank;
+  }
+  return rank;
+}
+
+inline bit_matrix bit_matrix::transitive_closure() const {
+  if (!square())
+    throw std::runtime_error("Cannot get closure of non-square matrix");
+  bit_matrix ret{*this};
+  for (std::size_t k = 0; k != n_rows; ++k) {
+    const std::size_t word = k / word_bits;
+    const std::uint64_t mask = std::uint64_t{1} << (k % word_bits);
+    const std::uint64_t* k_row = ret.row(k);
+    // Row k itself only ORs in its own bits, so it is skipped and never
+    // written while other rows read it
+    kernels::detail::split_rows(
+        n_rows, n_words, [&](std::size_t row_frst, std::size_t row_lst) {
+          for (std::size_t i = row_frst; i != row_lst; ++i) {
+            std::uint64_t* cur = ret.row(i);
+            if (i == k || !(cur[word] & mask))
+              continue;
+            for (std::size_t w = 0; w != n_words; ++w)
+              cur[w] |= k_row[w];
+          }
+        });
+  }
+  return ret;
+}
+
+}  // namespace linmath
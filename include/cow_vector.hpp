@@ -0,0 +1,112 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include "iterator.hpp"
+#include "vector.hpp"
+
+namespace containers {
+
+// Vector whose copies share one reference-counted buffer. The first
+// mutable access (non-const operator[], data(), begin() or end()) through a
+// copy that is not the only owner detaches it onto a private buffer. Const
+// access never detaches. A moved-from vector is empty and owns no block
+// until it is written to.
+template <typename T>
+class cow_vector {
+  struct block {
+    std::atomic<std::size_t> refs{1};
+    vector<T> buf;
+
+    explicit block(vector<T> buf_) : buf{std::move(buf_)} {}
+  };
+
+  block* m_block = nullptr;
+
+  void release() noexcept {
+    if (m_block && m_block->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+      delete m_block;
+    m_block = nullptr;
+  }
+
+  void detach() {
+    if (!m_block) {
+      m_block = new block{vector<T>{}};
+      return;
+    }
+    if (m_block->refs.load(std::memory_order_acquire) == 1)
+      return;
+    block* copy = new block{m_block->buf};
+    release();
+    m_block = copy;
+  }
+
+ public:
+  using it = iterator::myIterator<T>;
+  using const_it = iterator::myIterator<const T>;
+
+  cow_vector() : m_block{new block{vector<T>{}}} {}
+
+  explicit cow_vector(std::size_t count, T val = T{})
+      : m_block{new block{vector<T>(count, val)}} {}
+
+  cow_vector(std::size_t count, uninitialized_t)
+    requires std::is_trivially_copyable_v<T>
+      : m_block{new block{vector<T>(count, uninitialized)}} {}
+
+  ~cow_vector() { release(); }
+
+  cow_vector(const cow_vector& rhs) noexcept : m_block{rhs.m_block} {
+    if (m_block)
+      m_block->refs.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  cow_vector(cow_vector&& rhs) noexcept { std::swap(m_block, rhs.m_block); }
+
+  cow_vector& operator=(const cow_vector& rhs) noexcept {
+    cow_vector tmp{rhs};
+    std::swap(m_block, tmp.m_block);
+    return *this;
+  }
+
+  cow_vector& operator=(cow_vector&& rhs) noexcept {
+    if (this == std::addressof(rhs))
+      return *this;
+    std::swap(m_block, rhs.m_block);
+    return *this;
+  }
+
+  T& operator[](std::size_t i) {
+    detach();
+    return m_block->buf[i];
+  }
+  const T& operator[](std::size_t i) const { return data()[i]; }
+
+  T* data() {
+    detach();
+    return m_block->buf.data();
+  }
+  const T* data() const { return m_block ? m_block->buf.data() : nullptr; }
+
+  std::size_t size() const noexcept {
+    return m_block ? m_block->buf.size() : 0;
+  }
+  std::size_t capacity() const noexcept {
+    return m_block ? m_block->buf.capacity() : 0;
+  }
+  bool empty() const noexcept { return (size() == 0); }
+
+  // Number of copies sharing the buffer
+  std::size_t use_count() const noexcept {
+    return m_block ? m_block->refs.load(std::memory_order_relaxed) : 0;
+  }
+
+  it begin() { return it{data()}; }
+  it end() { return it{data() + size()}; }
+  const_it begin() const { return const_it{data()}; }
+  const_it end() const { return const_it{data() + size()}; }
+};
+
+}  // namespace containers
@@ -0,0 +1,238 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+#include "parallel.hpp"
+#include "shell_matrix.hpp"
+#include "vector.hpp"
+
+namespace linmath {
+
+template <typename T>
+struct eigen_settings {
+  // Width of the iterated block; 0 picks max(2 * k, k + 8)
+  std::size_t block_size = 0;
+  // Relative residual ||A x - l x|| / |l| required for every wanted pair
+  T tolerance = T{1.0e-6};
+  std::size_t max_iterations = 1000;
+};
+
+template <typename T>
+struct eigen_result {
+  // Ordered by decreasing magnitude
+  containers::vector<T> values;
+  // n x k, column i is the unit eigenvector for values[i]
+  shell_matrix<T> vectors;
+  std::size_t iterations = 0;
+  bool converged = false;
+};
+
+namespace detail {
+
+// Cyclic Jacobi rotations for the small p x p Rayleigh quotient.
+// On return h holds eigenvalues on its diagonal and v the eigenvectors.
+template <typename T>
+void jacobi_eigen(shell_matrix<T>& h, shell_matrix<T>& v,
+                  std::size_t max_sweeps = 64) {
+  std::size_t sz = h.nrows();
+  v = shell_matrix<T>::identity(sz);
+
+  for (std::size_t sweep = 0; sweep != max_sweeps; ++sweep) {
+    T off{};
+    for (std::size_t i = 0; i < sz; ++i)
+      for (std::size_t j = i + 1; j < sz; ++j)
+        off += h[i][j] * h[i][j];
+    if (off <= std::numeric_limits<T>::min())
+      return;
+
+    for (std::size_t p = 0; p < sz; ++p) {
+      for (std::size_t q = p + 1; q < sz; ++q) {
+        T apq = h[p][q];
+        if (std::abs(apq) <= std::numeric_limits<T>::min())
+          continue;
+        T theta = (h[q][q] - h[p][p]) / (2 * apq);
+        T t = (theta >= 0 ? T{1} : T{-1}) /
+              (std::abs(theta) + std::sqrt(theta * theta + 1));
+        T c = 1 / std::sqrt(t * t + 1);
+        T s = t * c;
+
+        for (std::size_t k = 0; k < sz; ++k) {
+          T hkp = h[k][p];
+          T hkq = h[k][q];
+          h[k][p] = c * hkp - s * hkq;
+          h[k][q] = s * hkp + c * hkq;
+        }
+        for (std::size_t k = 0; k < sz; ++k) {
+          T hpk = h[p][k];
+          T hqk = h[q][k];
+          h[p][k] = c * hpk - s * hqk;
+          h[q][k] = s * hpk + c * hqk;
+        }
+        for (std::size_t k = 0; k < sz; ++k) {
+          T vkp = v[k][p];
+          T vkq = v[k][q];
+          v[k][p] = c * vkp - s * vkq;
+          v[k][q] = s * vkp + c * vkq;
+        }
+      }
+    }
+  }
+}
+
+// Modified Gram-Schmidt over the columns of the n x p block, applied twice
+// for stability. Columns that collapse are replaced by a fresh direction.
+template <typename T>
+void orthonormalize(shell_matrix<T>& q, std::uint64_t& seed) {
+  std::size_t n = q.nrows();
+  std::size_t p = q.ncols();
+  T* ptr = q.data();
+
+  auto next_random = [&seed]() {
+    seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+    return static_cast<T>(static_cast<double>(seed >> 11) * 0x1.0p-53 - 0.5);
+  };
+
+  for (std::size_t j = 0; j < p; ++j) {
+    for (;;) {
+      T before{};
+      for (std::size_t r = 0; r < n; ++r)
+        before += ptr[r * p + j] * ptr[r * p + j];
+
+      for (int pass = 0; pass != 2; ++pass) {
+        for (std::size_t i = 0; i < j; ++i) {
+          T dot{};
+          for (std::size_t r = 0; r < n; ++r)
+            dot += ptr[r * p + i] * ptr[r * p + j];
+          for (std::size_t r = 0; r < n; ++r)
+            ptr[r * p + j] -= dot * ptr[r * p + i];
+        }
+      }
+
+      T after{};
+      for (std::size_t r = 0; r < n; ++r)
+        after += ptr[r * p + j] * ptr[r * p + j];
+      if (after > std::numeric_limits<T>::epsilon() * before &&
+          after > std::numeric_limits<T>::min()) {
+        T norm = std::sqrt(after);
+        for (std::size_t r = 0; r < n; ++r)
+          ptr[r * p + j] /= norm;
+        break;
+      }
+      for (std::size_t r = 0; r < n; ++r)
+        ptr[r * p + j] = next_random();
+    }
+  }
+}
+
+// lhs^T * rhs for two n x p blocks
+template <typename T>
+shell_matrix<T> gram(const shell_matrix<T>& lhs, const shell_matrix<T>& rhs) {
+  std::size_t n = lhs.nrows();
+  std::size_t p = lhs.ncols();
+  shell_matrix<T> ret{p, p};
+  const T* l = lhs.data();
+  const T* r = rhs.data();
+  parallel::for_each_chunk(p, 1, [&](std::size_t frst, std::size_t lst) {
+    for (std::size_t i = frst; i < lst; ++i)
+      for (std::size_t j = 0; j < p; ++j) {
+        T dot{};
+        for (std::size_t k = 0; k < n; ++k)
+          dot += l[k * p + i] * r[k * p + j];
+        ret[i][j] = dot;
+      }
+  });
+  return ret;
+}
+
+}  // namespace detail
+
+// Leading k eigenpairs of a symmetric operator by block subspace iteration
+// with Rayleigh-Ritz projection. apply(Q) must return A * Q for an n x p
+// block Q; memory stays at a few n x p blocks regardless of n.
+template <typename T, typename Op>
+eigen_result<T> top_eigenpairs(std::size_t n, Op&& apply, std::size_t k,
+                               const eigen_settings<T>& settings = {})
+    requires std::is_floating_point_v<T> {
+  if (k == 0 || k > n)
+    throw std::invalid_argument("Unsuitable number of eigenpairs");
+
+  std::size_t p = settings.block_size ? settings.block_size
+                                      : std::max(2 * k, k + 8);
+  p = std::clamp(p, k, n);
+
+  std::uint64_t seed = 0x853c49e6748fea9bULL;
+  shell_matrix<T> q{n, p};
+  detail::orthonormalize(q, seed);  // zero block is filled with random data
+
+  eigen_result<T> res{containers::vector<T>(k), shell_matrix<T>{n, k}};
+  shell_matrix<T> s{p, p};
+  std::vector<std::size_t> order(p);
+
+  for (std::size_t iter = 1; iter <= settings.max_iterations; ++iter) {
+    shell_matrix<T> w = apply(static_cast<const shell_matrix<T>&>(q));
+    if (w.nrows() != n || w.ncols() != p)
+      throw std::runtime_error("Unsuitable matrix sizes");
+
+    shell_matrix<T> h = detail::gram(q, w);
+    detail::jacobi_eigen(h, s);
+
+    std::iota(order.begin(), order.end(), std::size_t{0});
+    std::sort(order.begin(), order.end(), [&h](std::size_t a, std::size_t b) {
+      return std::abs(h[a][a]) > std::abs(h[b][b]);
+    });
+    shell_matrix<T> sorted{p, p};
+    for (std::size_t i = 0; i < p; ++i)
+      for (std::size_t j = 0; j < p; ++j)
+        sorted[i][j] = s[i][order[j]];
+
+    // Ritz vectors X = Q S and A X = W S share one product each
+    shell_matrix<T> x = q * sorted;
+    shell_matrix<T> ax = w * sorted;
+
+    bool converged = true;
+    for (std::size_t j = 0; j < k; ++j) {
+      T lambda = h[order[j]][order[j]];
+      T resid{};
+      for (std::size_t r = 0; r < n; ++r) {
+        T diff = ax[r][j] - lambda * x[r][j];
+        resid += diff * diff;
+      }
+      T scale = std::max(std::abs(lambda), std::numeric_limits<T>::min());
+      converged &= (std::sqrt(resid) <= settings.tolerance * scale);
+    }
+
+    res.iterations = iter;
+    if (converged || iter == settings.max_iterations) {
+      for (std::size_t j = 0; j < k; ++j) {
+        res.values[j] = h[order[j]][order[j]];
+        for (std::size_t r = 0; r < n; ++r)
+          res.vectors[r][j] = x[r][j];
+      }
+      res.converged = converged;
+      break;
+    }
+
+    q = std::move(ax);
+    detail::orthonormalize(q, seed);
+  }
+  return res;
+}
+
+template <typename T>
+eigen_result<T> top_eigenpairs(const shell_matrix<T>& a, std::size_t k,
+                               const eigen_settings<T>& settings = {})
+    requires std::is_floating_point_v<T> {
+  if (!a.square())
+    throw std::runtime_error("Unsuitable matrix size for eigenpairs");
+  return top_eigenpairs(
+      a.nrows(), [&a](const shell_matrix<T>& q) { return a * q; }, k,
+      settings);
+}
+
+}  // namespace linmath
@@ -0,0 +1,225 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include "kernels.hpp"
+#include "shell_matrix.hpp"
+#include "simd.hpp"
+
+namespace linmath {
+
+namespace detail {
+
+inline std::uint32_t float_bits(float f) {
+  std::uint32_t u;
+  std::memcpy(&u, &f, sizeof(u));
+  return u;
+}
+
+inline float bits_float(std::uint32_t u) {
+  float f;
+  std::memcpy(&f, &u, sizeof(f));
+  return f;
+}
+
+// IEEE binary16 conversions with round-to-nearest-even, subnormals,
+// infinities and quiet NaNs handled like F16C does
+inline std::uint16_t float_to_half_bits(float value) {
+  constexpr std::uint32_t f32_infty = 255u << 23;
+  constexpr std::uint32_t f16_max = (127u + 16) << 23;
+  constexpr std::uint32_t denorm_magic = ((127u - 15) + (23 - 10) + 1) << 23;
+
+  std::uint32_t u = float_bits(value);
+  const std::uint32_t sign = u & 0x80000000u;
+  u ^= sign;
+
+  std::uint16_t ret;
+  if (u >= f16_max) {
+    ret = u > f32_infty ? 0x7e00 : 0x7c00;
+  } else if (u < (113u << 23)) {
+    float f = bits_float(u) + bits_float(denorm_magic);
+    ret = static_cast<std::uint16_t>(float_bits(f) - denorm_magic);
+  } else {
+    std::uint32_t mant_odd = (u >> 13) & 1;
+    u += (static_cast<std::uint32_t>(15 - 127) << 23) + 0xfff;
+    u += mant_odd;
+    ret = static_cast<std::uint16_t>(u >> 13);
+  }
+  return static_cast<std::uint16_t>(ret | (sign >> 16));
+}
+
+inline float half_bits_to_float(std::uint16_t bits) {
+  constexpr std::uint32_t shifted_exp = 0x7c00u << 13;
+  const float magic = bits_float(113u << 23);
+
+  std::uint32_t u = (bits & 0x7fffu) << 13;
+  std::uint32_t exp = shifted_exp & u;
+  u += (127u - 15) << 23;
+  if (exp == shifted_exp) {
+    u += (128u - 16) << 23;
+  } else if (exp == 0) {
+    u += 1u << 23;
+    u = float_bits(bits_float(u) - magic);
+  }
+  return bits_float(u | (static_cast<std::uint32_t>(bits & 0x8000u) << 16));
+}
+
+inline std::uint16_t float_to_bfloat16_bits(float value) {
+  std::uint32_t u = float_bits(value);
+  if ((u & 0x7fffffffu) > 0x7f800000u)
+    return static_cast<std::uint16_t>((u >> 16) | 0x40);
+  u += 0x7fffu + ((u >> 16) & 1);
+  return static_cast<std::uint16_t>(u >> 16);
+}
+
+inline float bfloat16_bits_to_float(std::uint16_t bits) {
+  return bits_float(static_cast<std::uint32_t>(bits) << 16);
+}
+
+}  // namespace detail
+
+// 16-bit storage formats. Values convert implicitly to and from float and
+// every operation is carried out in float; only compound assignment is
+// defined so mixed expressions resolve to plain float arithmetic.
+template <typename Tag>
+class basic_half final {
+  std::uint16_t m_bits = 0;
+
+ public:
+  basic_half() = default;
+  basic_half(float value) : m_bits{Tag::from_float(value)} {}
+
+  static basic_half from_bits(std::uint16_t bits) {
+    basic_half ret;
+    ret.m_bits = bits;
+    return ret;
+  }
+
+  operator float() const { return Tag::to_float(m_bits); }
+  std::uint16_t bits() const { return m_bits; }
+
+  basic_half& operator+=(float rhs) { return *this = float(*this) + rhs; }
+  basic_half& operator-=(float rhs) { return *this = float(*this) - rhs; }
+  basic_half& operator*=(float rhs) { return *this = float(*this) * rhs; }
+  basic_half& operator/=(float rhs) { return *this = float(*this) / rhs; }
+};
+
+struct half_tag {
+  static std::uint16_t from_float(float v) {
+    return detail::float_to_half_bits(v);
+  }
+  static float to_float(std::uint16_t b) {
+    return detail::half_bits_to_float(b);
+  }
+};
+
+struct bfloat16_tag {
+  static std::uint16_t from_float(float v) {
+    return detail::float_to_bfloat16_bits(v);
+  }
+  static float to_float(std::uint16_t b) {
+    return detail::bfloat16_bits_to_float(b);
+  }
+};
+
+using half = basic_half<half_tag>;
+using bfloat16 = basic_half<bfloat16_tag>;
+
+static_assert(sizeof(half) == 2 && sizeof(bfloat16) == 2);
+
+namespace kernels {
+namespace detail {
+
+#ifdef LINMATH_X86_DISPATCH
+__attribute__((target("avx,f16c"))) inline void widen_f16c(
+    const std::uint16_t* src, float* dst, std::size_t count) {
+  std::size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(h));
+  }
+  for (; i < count; ++i)
+    dst[i] = linmath::detail::half_bits_to_float(src[i]);
+}
+
+__attribute__((target("avx,f16c"))) inline void narrow_f16c(
+    const float* src, std::uint16_t* dst, std::size_t count) {
+  std::size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m128i h = _mm256_cvtps_ph(_mm256_loadu_ps(src + i),
+                                _MM_FROUND_TO_NEAREST_INT);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), h);
+  }
+  for (; i < count; ++i)
+    dst[i] = linmath::detail::float_to_half_bits(src[i]);
+}
+#endif
+
+}  // namespace detail
+}  // namespace kernels
+
+template <>
+struct compute_type<half> {
+  using type = float;
+
+  static void widen(const half* src, float* dst, std::size_t count) {
+    auto bits = reinterpret_cast<const std::uint16_t*>(src);
+#ifdef LINMATH_X86_DISPATCH
+    if (simd::has_f16c()) {
+      kernels::detail::widen_f16c(bits, dst, count);
+      return;
+    }
+#endif
+    for (std::size_t i = 0; i < count; ++i)
+      dst[i] = detail::half_bits_to_float(bits[i]);
+  }
+
+  static void narrow(const float* src, half* dst, std::size_t count) {
+    auto bits = reinterpret_cast<std::uint16_t*>(dst);
+#ifdef LINMATH_X86_DISPATCH
+    if (simd::has_f16c()) {
+      kernels::detail::narrow_f16c(src, bits, count);
+      return;
+    }
+#endif
+    for (std::size_t i = 0; i < count; ++i)
+      bits[i] = detail::float_to_half_bits(src[i]);
+  }
+};
+
+// bfloat16 is the upper half of a float, plain shifts vectorize well
+template <>
+struct compute_type<bfloat16> {
+  using type = float;
+
+  static void widen(const bfloat16* src, float* dst, std::size_t count) {
+    auto bits = reinterpret_cast<const std::uint16_t*>(src);
+    for (std::size_t i = 0; i < count; ++i)
+      dst[i] = detail::bfloat16_bits_to_float(bits[i]);
+  }
+
+  static void narrow(const float* src, bfloat16* dst, std::size_t count) {
+    auto bits = reinterpret_cast<std::uint16_t*>(dst);
+    for (std::size_t i = 0; i < count; ++i)
+      bits[i] = detail::float_to_bfloat16_bits(src[i]);
+  }
+};
+
+// Absolute tolerances for values of order one
+template <>
+struct default_precision<half> {
+  static constexpr float prec = 1.0e-2f;
+};
+
+template <>
+struct default_precision<bfloat16> {
+  static constexpr float prec = 5.0e-2f;
+};
+
+template <typename Tag>
+std::ostream& operator<<(std::ostream& os, basic_half<Tag> value) {
+  return os << static_cast<float>(value);
+}
+
+}  // namespace linmath
@@ -0,0 +1,313 @@
+#pragma once
+
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <version>
+#include "kernels.hpp"
+#include "parallel.hpp"
+#include "shell_matrix.hpp"
+
+namespace linmath {
+
+namespace detail {
+
+// Input is split into this many pieces per pool thread, so uneven lines
+// still balance out
+static constexpr std::size_t io_parts_per_thread = 4;
+// Below this size text is handled on the calling thread
+static constexpr std::size_t io_parallel_bytes = std::size_t{1} << 16;
+// Output is formatted in blocks of roughly this many bytes
+static constexpr std::size_t io_block_bytes = std::size_t{1} << 22;
+
+inline bool is_blank(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+inline bool is_delimiter(char c) { return c == ',' || c == ';'; }
+
+inline const char* skip_blanks(const char* frst, const char* lst) {
+  while (frst != lst && is_blank(*frst))
+    ++frst;
+  return frst;
+}
+
+// Steps over the gap after a value: blanks with at most one , or ; among
+// them. Each delimiter ends exactly one field, so a second delimiter or a
+// delimiter at the end of the line means an empty field.
+inline const char* skip_separator(const char* frst, const char* lst) {
+  frst = skip_blanks(frst, lst);
+  if (frst != lst && is_delimiter(*frst)) {
+    frst = skip_blanks(frst + 1, lst);
+    if (frst == lst || is_delimiter(*frst))
+      throw std::runtime_error("Empty field in matrix text");
+  }
+  return frst;
+}
+
+// Parses one number, returns the position after it or nullptr.
+// The text must be followed by a non-numeric character or NUL, which
+// the strtod fallback relies on.
+template <typename V>
+const char* parse_value(const char* frst, const char* lst, V& out) {
+  if (frst != lst && *frst == '+')
+    ++frst;
+#if defined(__cpp_lib_to_chars)
+  auto [ptr, ec] = std::from_chars(frst, lst, out);
+  return ec == std::errc{} ? ptr : nullptr;
+#else
+  if constexpr (std::is_integral_v<V>) {
+    auto [ptr, ec] = std::from_chars(frst, lst, out);
+    return ec == std::errc{} ? ptr : nullptr;
+  } else {
+    char* end = nullptr;
+    out = static_cast<V>(std::strtod(frst, &end));
+    return (end == frst || end > lst) ? nullptr : end;
+  }
+#endif
+}
+
+template <typename V>
+char* format_value(char* frst, char* lst, V value) {
+#if defined(__cpp_lib_to_chars)
+  return std::to_chars(frst, lst, value).ptr;
+#else
+  if constexpr (std::is_integral_v<V>) {
+    return std::to_chars(frst, lst, value).ptr;
+  } else {
+    int len = std::snprintf(frst, lst - frst, "%.*g",
+                            std::numeric_limits<V>::max_digits10,
+                            static_cast<double>(value));
+    return frst + len;
+  }
+#endif
+}
+
+// Parses every non-empty line of [frst, lst) as one row of n_cols values
+// into out; returns the number of rows written
+template <typename T>
+std::size_t parse_rows(const char* frst, const char* lst, std::size_t n_cols,
+                       T* out) {
+  using value_t = compute_t<T>;
+  std::size_t rows = 0;
+  while (frst != lst) {
+    const char* eol = static_cast<const char*>(
+        std::memchr(frst, '\n', lst - frst));
+    if (!eol)
+      eol = lst;
+
+    const char* cur = skip_blanks(frst, eol);
+    if (cur != eol) {
+      for (std::size_t j = 0; j != n_cols; ++j) {
+        if (is_delimiter(*cur))
+          throw std::runtime_error("Empty field in matrix text");
+        value_t val{};
+        cur = parse_value(cur, eol, val);
+        if (!cur)
+          throw std::runtime_error("Malformed matrix text");
+        out[rows * n_cols + j] = static_cast<T>(val);
+        cur = skip_separator(cur, eol);
+        if ((cur == eol) != (j + 1 == n_cols))
+          throw std::runtime_error("Inconsistent number of columns");
+      }
+      ++rows;
+    }
+    frst = eol == lst ? lst : eol + 1;
+  }
+  return rows;
+}
+
+inline std::size_t count_rows(const char* frst, const char* lst) {
+  std::size_t rows = 0;
+  while (frst != lst) {
+    const char* eol = static_cast<const char*>(
+        std::memchr(frst, '\n', lst - frst));
+    if (!eol)
+      eol = lst;
+    rows += skip_blanks(frst, eol) != eol;
+    frst = eol == lst ? lst : eol + 1;
+  }
+  return rows;
+}
+
+inline std::size_t count_values(const char* frst, const char* lst) {
+  std::size_t count = 0;
+  for (frst = skip_blanks(frst, lst); frst != lst; ++count) {
+    while (frst != lst && !is_blank(*frst) && !is_delimiter(*frst))
+      ++frst;
+    frst = skip_separator(frst, lst);
+  }
+  return count;
+}
+
+}  // namespace detail
+
+// Parses whitespace, comma or semicolon separated text, one row per line.
+// Blank lines are skipped; an empty comma or semicolon field throws. The
+// text is split at line boundaries and the pieces are parsed in parallel
+// straight into the matrix buffer.
+template <typename T>
+shell_matrix<T> parse_text(const std::string& text) {
+  const char* frst = text.data();
+  const char* lst = frst + text.size();
+
+  const char* first_row = frst;
+  std::size_t n_cols = 0;
+  while (first_row != lst && n_cols == 0) {
+    const char* eol = static_cast<const char*>(
+        std::memchr(first_row, '\n', lst - first_row));
+    if (!eol)
+      eol = lst;
+    n_cols = detail::count_values(first_row, eol);
+    first_row = eol == lst ? lst : eol + 1;
+  }
+  if (n_cols == 0)
+    return shell_matrix<T>{0, 0};
+
+  std::size_t n_parts = 1;
+  if (text.size() >= detail::io_parallel_bytes)
+    n_parts = parallel::default_pool().size() * detail::io_parts_per_thread;
+
+  // Part boundaries sit just after a newline
+  std::vector<const char*> bounds(n_parts + 1, lst);
+  bounds[0] = frst;
+  for (std::size_t idx = 1; idx < n_parts; ++idx) {
+    const char* pos = std::max(frst + text.size() * idx / n_parts,
+                               bounds[idx - 1]);
+    const char* eol =
+        static_cast<const char*>(std::memchr(pos, '\n', lst - pos));
+    bounds[idx] = eol ? eol + 1 : lst;
+  }
+
+  std::vector<std::size_t> row_offset(n_parts + 1, 0);
+  parallel::for_each_chunk(n_parts, 1, [&](std::size_t b, std::size_t e) {
+    for (std::size_t idx = b; idx != e; ++idx)
+      row_offset[idx + 1] = detail::count_rows(bounds[idx], bounds[idx + 1]);
+  });
+  for (std::size_t idx = 0; idx != n_parts; ++idx)
+    row_offset[idx + 1] += row_offset[idx];
+
+  // parse_rows writes every element or throws, so plain types skip the
+  // serial zero fill and each page is first touched by the thread parsing it
+  const std::size_t n_rows = row_offset[n_parts];
+  auto ret = [n_rows, n_cols] {
+    if constexpr (std::is_trivially_copyable_v<T>)
+      return shell_matrix<T>{n_rows, n_cols, containers::uninitialized};
+    else
+      return shell_matrix<T>{n_rows, n_cols};
+  }();
+  T* out = ret.data();
+  parallel::for_each_chunk(n_parts, 1, [&](std::size_t b, std::size_t e) {
+    for (std::size_t idx = b; idx != e; ++idx)
+      detail::parse_rows(bounds[idx], bounds[idx + 1], n_cols,
+                         out + row_offset[idx] * n_cols);
+  });
+  return ret;
+}
+
+// Seekable streams are read with one call, others through their buffer
+template <typename T>
+shell_matrix<T> read_text(std::istream& is) {
+  std::string text;
+  const std::streampos start = is.tellg();
+  if (start != std::streampos(-1) && is.seekg(0, std::ios::end)) {
+    text.resize(static_cast<std::size_t>(is.tellg() - start));
+    is.seekg(start);
+    is.read(text.data(), static_cast<std::streamsize>(text.size()));
+    text.resize(static_cast<std::size_t>(is.gcount()));
+  } else {
+    is.clear();
+    std::ostringstream buf;
+    buf << is.rdbuf();
+    text = std::move(buf).str();
+  }
+  return parse_text<T>(text);
+}
+
+template <typename T>
+shell_matrix<T> load_text(const std::string& path) {
+  std::ifstream file{path, std::ios::binary | std::ios::ate};
+  if (!file)
+    throw std::runtime_error("Cannot open " + path);
+  std::string text(static_cast<std::size_t>(file.tellg()), '\0');
+  file.seekg(0);
+  file.read(text.data(), static_cast<std::streamsize>(text.size()));
+  return parse_text<T>(text);
+}
+
+// Writes one row per line with values in shortest round-trip form. Rows
+// are formatted in parallel into large buffers that are written in order.
+template <typename T>
+void write_text(std::ostream& os, const shell_matrix<T>& matr,
+                char delimiter = ' ') {
+  using value_t = compute_t<T>;
+  constexpr std::size_t max_len = 64;
+
+  const std::size_t n_rows = matr.nrows();
+  const std::size_t n_cols = matr.ncols();
+  const T* src = matr.data();
+  if (n_cols == 0)
+    return;
+
+  const std::size_t n_parts = parallel::default_pool().size();
+  const std::size_t block_rows =
+      std::max<std::size_t>(1, detail::io_block_bytes / (n_cols * 16));
+  std::vector<std::string> buffers(n_parts);
+
+  for (std::size_t blk = 0; blk < n_rows; blk += block_rows) {
+    const std::size_t blk_lst = std::min(n_rows, blk + block_rows);
+    const std::size_t blk_rows = blk_lst - blk;
+    const std::size_t parts = std::min(n_parts, blk_rows);
+
+    parallel::for_each_chunk(parts, 1, [&](std::size_t b, std::size_t e) {
+      for (std::size_t idx = b; idx != e; ++idx) {
+        std::string& buf = buffers[idx];
+        buf.resize(std::max<std::size_t>(buf.capacity(), 4096));
+        std::size_t pos = 0;
+        for (std::size_t i = blk + blk_rows * idx / parts;
+             i != blk + blk_rows * (idx + 1) / parts; ++i) {
+          for (std::size_t j = 0; j != n_cols; ++j) {
+            if (buf.size() - pos < max_len + 2)
+              buf.resize(2 * buf.size());
+            char* cur = buf.data() + pos;
+            cur = detail::format_value(cur, cur + max_len,
+                                       static_cast<value_t>(
+                                           src[i * n_cols + j]));
+            *cur++ = (j + 1 == n_cols) ? '\n' : delimiter;
+            pos = cur - buf.data();
+          }
+        }
+        buf.resize(pos);
+      }
+    });
+
+    for (std::size_t idx = 0; idx != parts; ++idx) {
+      os.write(buffers[idx].data(),
+               static_cast<std::streamsize>(buffers[idx].size()));
+      buffers[idx].clear();
+    }
+  }
+}
+
+template <typename T>
+void save_text(const std::string& path, const shell_matrix<T>& matr,
+               char delimiter = ' ') {
+  std::ofstream file{path, std::ios::binary};
+  if (!file)
+    throw std::runtime_error("Cannot open " + path);
+  write_text(file, matr, delimiter);
+  if (!file)
+    throw std::runtime_error("Cannot write " + path);
+}
+
+}  // namespace linmath
@@ -1,24 +1,30 @@
 #pragma once
 
+#include <compare>
 #include <concepts>
+#include <cstddef>
 #include <iterator>
+#include <type_traits>
 
 namespace iterator {
+// Pointer wrapper over contiguous storage, models std::contiguous_iterator
 template <typename T>
 class myIterator {
   T* ptr = nullptr;
 
  public:
-  myIterator(T* ptr_ = nullptr) : ptr{ptr_} {}
-
-  T& operator*() { return *ptr; }
-  const T& operator*() const { return *ptr; }
+  using iterator_category = std::random_access_iterator_tag;
+  using iterator_concept = std::contiguous_iterator_tag;
+  using value_type = std::remove_cv_t<T>;
+  using difference_type = std::ptrdiff_t;
+  using pointer = T*;
+  using reference = T&;
 
-  T* operator->() { return ptr; }
-  const T* operator->() const { return ptr; }
+  myIterator(T* ptr_ = nullptr) : ptr{ptr_} {}
 
-  T& operator[](std::ptrdiff_t i) { return *(*this + i); }
-  const T& operator[](std::ptrdiff_t i) const { return *(*this + i); }
+  T& operator*() const { return *ptr; }
+  T* operator->() const { return ptr; }
+  T& operator[](difference_type i) const { return ptr[i]; }
 
   myIterator& operator++() {
     ++ptr;
@@ -39,26 +45,106 @@ class myIterator {
     return tmp;
   }
 
-  myIterator& operator+=(std::ptrdiff_t i) {
+  myIterator& operator+=(difference_type i) {
     ptr += i;
     return *this;
   }
-  myIterator& operator-=(std::ptrdiff_t i) {
+  myIterator& operator-=(difference_type i) {
     ptr -= i;
     return *this;
   }
 
-  myIterator operator+(std::ptrdiff_t i) {
+  myIterator operator+(difference_type i) const {
     myIterator tmp{*this};
     tmp += i;
     return tmp;
   }
-  myIterator operator-(std::ptrdiff_t i) {
+  friend myIterator operator+(difference_type i, const myIterator& rhs) {
+    return rhs + i;
+  }
+  myIterator operator-(difference_type i) const {
     myIterator tmp{*this};
     tmp -= i;
     return tmp;
   }
+  difference_type operator-(const myIterator& rhs) const {
+    return ptr - rhs.ptr;
+  }
 
+  bool operator==(const myIterator& rhs) const = default;
   auto operator<=>(const myIterator& rhs) const = default;
 };
+
+// Every stride-th element starting at base, e.g. a matrix column.
+// Keeps an index rather than a pointer so the end position never points
+// past the storage.
+template <typename T>
+class strided_iterator {
+  T* base = nullptr;
+  std::ptrdiff_t idx = 0;
+  std::ptrdiff_t stride = 1;
+
+ public:
+  using iterator_category = std::random_access_iterator_tag;
+  using iterator_concept = std::random_access_iterator_tag;
+  using value_type = std::remove_cv_t<T>;
+  using difference_type = std::ptrdiff_t;
+  using pointer = T*;
+  using reference = T&;
+
+  strided_iterator() = default;
+  strided_iterator(T* base_, std::ptrdiff_t idx_, std::ptrdiff_t stride_)
+      : base{base_}, idx{idx_}, stride{stride_} {}
+
+  T& operator*() const { return base[idx * stride]; }
+  T* operator->() const { return base + idx * stride; }
+  T& operator[](difference_type i) const { return base[(idx + i) * stride]; }
+
+  strided_iterator& operator++() {
+    ++idx;
+    return *this;
+  }
+  strided_iterator operator++(int) {
+    strided_iterator tmp{*this};
+    ++idx;
+    return tmp;
+  }
+  strided_iterator& operator--() {
+    --idx;
+    return *this;
+  }
+  strided_iterator operator--(int) {
+    strided_iterator tmp{*this};
+    --idx;
+    return tmp;
+  }
+
+  strided_iterator& operator+=(difference_type i) {
+    idx += i;
+    return *this;
+  }
+  strided_iterator& operator-=(difference_type i) {
+    idx -= i;
+    return *this;
+  }
+
+  strided_iterator operator+(difference_type i) const {
+    return strided_iterator{base, idx + i, stride};
+  }
+  friend strided_iterator operator+(difference_type i,
+                                    const strided_iterator& rhs) {
+    return rhs + i;
+  }
+  strided_iterator operator-(difference_type i) const {
+    return strided_iterator{base, idx - i, stride};
+  }
+  difference_type operator-(const strided_iterator& rhs) const {
+    return idx - rhs.idx;
+  }
+
+  bool operator==(const strided_iterator& rhs) const { return idx == rhs.idx; }
+  auto operator<=>(const strided_iterator& rhs) const {
+    return idx <=> rhs.idx;
+  }
+};
 }  // namespace iterator
\ No newline at end of file
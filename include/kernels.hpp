@@ -0,0 +1,367 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "parallel.hpp"
+#include "simd.hpp"
+#include "tuning.hpp"
+
+namespace linmath {
+
+// Arithmetic type for an element type. Storage formats narrower than their
+// arithmetic (see half.hpp) specialise this with type = float and bulk
+// widen(src, dst, count) / narrow(src, dst, count) conversions.
+template <typename T>
+struct compute_type {
+  using type = T;
+};
+
+template <typename T>
+using compute_t = typename compute_type<T>::type;
+
+template <typename T>
+inline constexpr bool is_widened_v = !std::is_same_v<compute_t<T>, T>;
+
+namespace kernels {
+
+namespace detail {
+
+// Runs rows(frst, lst) over [0, n), split across the pool once the total
+// work of n rows of row_work operations reaches threshold. The threshold
+// only decides whether to split: the partition itself depends on n and the
+// pool size alone, so every row-parallel kernel hands the same rows of an
+// n-row matrix to the same thread.
+template <typename F>
+void split_rows(std::size_t n, std::size_t row_work, F&& rows,
+                std::size_t threshold = params().gemm_parallel_threshold) {
+  if (n * row_work < threshold) {
+    rows(std::size_t{0}, n);
+    return;
+  }
+  parallel::for_each_chunk(n, 1, rows);
+}
+
+// Narrow storage: products are accumulated in the compute type. Each
+// thread widens a tile of rows of A and C, then streams B through a
+// per-thread buffer one k-panel of gemm_block rows at a time, so B is never
+// widened as a whole and every panel is reused by the whole row tile.
+template <typename T>
+void gemm_widened(const T* a, const T* b, T* c, std::size_t n, std::size_t k,
+                  std::size_t m) {
+  using conv = compute_type<T>;
+  using wide_t = compute_t<T>;
+  constexpr std::size_t row_tile = 64;
+  const std::size_t block =
+      std::max<std::size_t>(1, std::min(params().gemm_block, k));
+
+  split_rows(n, k * m, [=](std::size_t row_frst, std::size_t row_lst) {
+    const std::size_t tile = std::min(row_tile, row_lst - row_frst);
+    std::vector<wide_t> a_tile(tile * k);
+    std::vector<wide_t> c_tile(tile * m);
+    std::vector<wide_t> b_panel(block * m);
+    for (std::size_t ii = row_frst; ii < row_lst; ii += tile) {
+      const std::size_t rows = std::min(tile, row_lst - ii);
+      conv::widen(a + ii * k, a_tile.data(), rows * k);
+      conv::widen(c + ii * m, c_tile.data(), rows * m);
+      for (std::size_t kk = 0; kk < k; kk += block) {
+        const std::size_t depth = std::min(block, k - kk);
+        conv::widen(b + kk * m, b_panel.data(), depth * m);
+        for (std::size_t i = 0; i < rows; ++i) {
+          wide_t* c_row = c_tile.data() + i * m;
+          const wide_t* a_row = a_tile.data() + i * k + kk;
+          for (std::size_t p = 0; p < depth; ++p) {
+            const wide_t r = a_row[p];
+            const wide_t* b_row = b_panel.data() + p * m;
+            for (std::size_t j = 0; j < m; ++j)
+              c_row[j] += r * b_row[j];
+          }
+        }
+      }
+      conv::narrow(c_tile.data(), c + ii * m, rows * m);
+    }
+  });
+}
+
+}  // namespace detail
+
+// Row-partitioned fill and copy of n x m storage. Above the threshold the
+// rows are split exactly as the row-parallel kernels split them and every
+// chunk runs on the same pool thread, so each page is first touched by the
+// thread that later works on it. The pages only stay local if the OS
+// keeps that thread on its node (e.g. under numactl or taskset); the pool
+// sets no affinity itself. dst may be uninitialized.
+template <typename T>
+void fill(T* dst, std::size_t n, std::size_t m, const T& val) {
+  detail::split_rows(
+      n, m,
+      [=](std::size_t row_frst, std::size_t row_lst) {
+        std::uninitialized_fill(dst + row_frst * m, dst + row_lst * m, val);
+      },
+      params().fill_parallel_threshold);
+}
+
+template <typename T>
+void copy(const T* src, T* dst, std::size_t n, std::size_t m) {
+  detail::split_rows(
+      n, m,
+      [=](std::size_t row_frst, std::size_t row_lst) {
+        std::uninitialized_copy(src + row_frst * m, src + row_lst * m,
+                                dst + row_frst * m);
+      },
+      params().fill_parallel_threshold);
+}
+
+// C[n x m] += A[n x k] * B[k x m], all row-major and contiguous.
+// Rows of C are split across the thread pool.
+template <typename T>
+void gemm(const T* a, const T* b, T* c, std::size_t n, std::size_t k,
+          std::size_t m) {
+  if constexpr (is_widened_v<T>) {
+    detail::gemm_widened(a, b, c, n, k, m);
+  } else {
+    const std::size_t block = params().gemm_block;
+    detail::split_rows(n, k * m, [=](std::size_t row_frst,
+                                     std::size_t row_lst) {
+      for (std::size_t kk = 0; kk < k; kk += block) {
+        std::size_t k_lst = std::min(kk + block, k);
+        for (std::size_t i = row_frst; i < row_lst; ++i) {
+          T* c_row = c + i * m;
+          for (std::size_t p = kk; p < k_lst; ++p) {
+            const T r = a[i * k + p];
+            const T* b_row = b + p * m;
+            for (std::size_t j = 0; j < m; ++j)
+              c_row[j] += r * b_row[j];
+          }
+        }
+      }
+    });
+  }
+}
+
+// dst[m x n] = transpose of src[n x m], tile by tile so both sides stay
+// in cache. Rows of dst are split across the pool; dst may be
+// uninitialized.
+template <typename T>
+void transpose(const T* src, T* dst, std::size_t n, std::size_t m) {
+  const std::size_t block = params().transpose_block;
+  detail::split_rows(
+      m, n,
+      [=](std::size_t col_frst, std::size_t col_lst) {
+        for (std::size_t ii = 0; ii < n; ii += block) {
+          const std::size_t i_lst = std::min(ii + block, n);
+          for (std::size_t jj = col_frst; jj < col_lst; jj += block) {
+            const std::size_t j_lst = std::min(jj + block, col_lst);
+            for (std::size_t j = jj; j < j_lst; ++j)
+              for (std::size_t i = ii; i < i_lst; ++i)
+                dst[j * n + i] = src[i * m + j];
+          }
+        }
+      },
+      params().fill_parallel_threshold);
+}
+
+// In-place transpose of a square n x n matrix. Each task owns a row of
+// tiles and swaps it with the matching column of tiles.
+template <typename T>
+void transpose_inplace(T* a, std::size_t n) {
+  const std::size_t block = params().transpose_block;
+  const std::size_t n_tiles = (n + block - 1) / block;
+  detail::split_rows(
+      n_tiles, n * block / 2,
+      [=](std::size_t tile_frst, std::size_t tile_lst) {
+        for (std::size_t ti = tile_frst; ti < tile_lst; ++ti) {
+          const std::size_t ii = ti * block;
+          const std::size_t i_lst = std::min(ii + block, n);
+          for (std::size_t jj = ii; jj < n; jj += block) {
+            const std::size_t j_lst = std::min(jj + block, n);
+            for (std::size_t i = ii; i < i_lst; ++i)
+              for (std::size_t j = std::max(jj, i + 1); j < j_lst; ++j)
+                std::swap(a[i * n + j], a[j * n + i]);
+          }
+        }
+      },
+      params().fill_parallel_threshold);
+}
+
+// dst[i] = op(dst[i], src[i]) for narrow storage types, converted to the
+// compute type in blocks that stay in L1
+template <typename T, typename Op>
+void elementwise_widened(T* dst, const T* src, std::size_t count, Op op) {
+  using conv = compute_type<T>;
+  constexpr std::size_t block = 256;
+  compute_t<T> lhs[block];
+  compute_t<T> rhs[block];
+  for (std::size_t off = 0; off < count; off += block) {
+    std::size_t len = std::min(block, count - off);
+    conv::widen(dst + off, lhs, len);
+    conv::widen(src + off, rhs, len);
+    for (std::size_t i = 0; i < len; ++i)
+      lhs[i] = op(lhs[i], rhs[i]);
+    conv::narrow(lhs, dst + off, len);
+  }
+}
+
+// dst[i] = op(dst[i]) for narrow storage types
+template <typename T, typename Op>
+void elementwise_widened(T* dst, std::size_t count, Op op) {
+  using conv = compute_type<T>;
+  constexpr std::size_t block = 256;
+  compute_t<T> vals[block];
+  for (std::size_t off = 0; off < count; off += block) {
+    std::size_t len = std::min(block, count - off);
+    conv::widen(dst + off, vals, len);
+    for (std::size_t i = 0; i < len; ++i)
+      vals[i] = op(vals[i]);
+    conv::narrow(vals, dst + off, len);
+  }
+}
+
+namespace detail {
+
+// dst[i] = fn(src[i]...) for narrow storage, with every source widened
+// into L1-sized blocks first
+template <typename T, typename F, typename... Src>
+void map_widened(T* dst, std::size_t count, F& fn, const Src*... src) {
+  using conv = compute_type<T>;
+  using wide_t = compute_t<T>;
+  constexpr std::size_t block = 256;
+  wide_t in[sizeof...(Src)][block];
+  wide_t out[block];
+  for (std::size_t off = 0; off < count; off += block) {
+    std::size_t len = std::min(block, count - off);
+    [&]<std::size_t... I>(std::index_sequence<I...>) {
+      (conv::widen(src + off, in[I], len), ...);
+      for (std::size_t i = 0; i < len; ++i)
+        out[i] = static_cast<wide_t>(fn(in[I][i]...));
+    }(std::index_sequence_for<Src...>{});
+    conv::narrow(out, dst + off, len);
+  }
+}
+
+}  // namespace detail
+
+// dst[i] = fn(src[i]...) over n x m contiguous elements, one to three
+// sources fused in a single pass; dst may be one of the sources. The
+// loop body is a plain indexed loop so fn inlines and vectorizes, and
+// rows are split across the pool like the other row-parallel kernels.
+template <typename T, typename F, typename... Src>
+void map(T* dst, std::size_t n, std::size_t m, F fn, const Src*... src) {
+  static_assert(sizeof...(Src) >= 1 && sizeof...(Src) <= 3,
+                "map takes one to three sources");
+  detail::split_rows(
+      n, m,
+      [=](std::size_t row_frst, std::size_t row_lst) mutable {
+        const std::size_t frst = row_frst * m;
+        const std::size_t lst = row_lst * m;
+        if constexpr (is_widened_v<T> && (std::is_same_v<Src, T> && ...)) {
+          detail::map_widened(dst + frst, lst - frst, fn, (src + frst)...);
+        } else {
+          for (std::size_t i = frst; i < lst; ++i)
+            dst[i] = static_cast<T>(fn(src[i]...));
+        }
+      },
+      params().map_parallel_threshold);
+}
+
+// Sum of count elements accumulated in the compute type. Blocks are summed
+// in index order and merged by parallel::reduce, so in deterministic mode
+// the result is the same for any pool size.
+template <typename T>
+compute_t<T> sum(const T* src, std::size_t count) {
+  using wide_t = compute_t<T>;
+  return parallel::reduce(
+      count, wide_t{},
+      [src](std::size_t frst, std::size_t lst) {
+        wide_t acc{};
+        for (std::size_t i = frst; i != lst; ++i)
+          acc += static_cast<wide_t>(src[i]);
+        return acc;
+      },
+      std::plus<wide_t>{});
+}
+
+// Dot product of two ranges of count elements, reduced like sum()
+template <typename T>
+compute_t<T> dot(const T* a, const T* b, std::size_t count) {
+  using wide_t = compute_t<T>;
+  return parallel::reduce(
+      count, wide_t{},
+      [a, b](std::size_t frst, std::size_t lst) {
+        wide_t acc{};
+        for (std::size_t i = frst; i != lst; ++i)
+          acc += static_cast<wide_t>(a[i]) * static_cast<wide_t>(b[i]);
+        return acc;
+      },
+      std::plus<wide_t>{});
+}
+
+// Barrett reduction for moduli below 2^32: any 64-bit value is reduced
+// with one high multiply and at most one correction.
+class barrett_reducer final {
+  std::uint64_t m_mod;
+  std::uint64_t m_mu;
+
+ public:
+  explicit barrett_reducer(std::uint64_t mod)
+      : m_mod{mod}, m_mu{~std::uint64_t{0} / mod} {}
+
+  std::uint64_t reduce(std::uint64_t x) const {
+    auto q = static_cast<std::uint64_t>(
+        (static_cast<unsigned __int128>(x) * m_mu) >> 64);
+    std::uint64_t r = x - q * m_mod;
+    return r >= m_mod ? r - m_mod : r;
+  }
+
+  std::uint64_t mod() const { return m_mod; }
+};
+
+// C[n x m] = A[n x k] * B[k x m] mod red.mod(). Entries of A and B must
+// already lie in [0, mod). Products are summed unreduced in 64 bits and
+// reduced once per run of L of them, so the inner loop is a plain
+// multiply-add that vectorizes. With values below mod a reduced partial
+// sum plus L products stays below 2^64 while
+// (mod - 1) + L * (mod - 1)^2 < 2^64: L = 15 for mod ~ 2^30, L = 1 only
+// for moduli close to 2^32.
+template <typename T>
+void gemm_mod(const T* a, const T* b, T* c, std::size_t n, std::size_t k,
+              std::size_t m, const barrett_reducer& red) {
+  const std::uint64_t top = red.mod() - 1;
+  if (top == 0) {
+    std::fill_n(c, n * m, T{});
+    return;
+  }
+  const std::size_t run = static_cast<std::size_t>(std::min<std::uint64_t>(
+      (~std::uint64_t{0} - top) / (top * top), k));
+
+  detail::split_rows(n, k * m, [=](std::size_t row_frst, std::size_t row_lst) {
+    std::vector<std::uint64_t> acc(m);
+    for (std::size_t i = row_frst; i < row_lst; ++i) {
+      std::fill(acc.begin(), acc.end(), 0);
+      for (std::size_t pp = 0; pp < k; pp += run) {
+        const std::size_t p_lst = std::min(pp + run, k);
+        for (std::size_t p = pp; p < p_lst; ++p) {
+          const auto r = static_cast<std::uint64_t>(a[i * k + p]);
+          if (r == 0)
+            continue;
+          const T* b_row = b + p * m;
+          for (std::size_t j = 0; j < m; ++j)
+            acc[j] += r * static_cast<std::uint64_t>(b_row[j]);
+        }
+        for (std::size_t j = 0; j < m; ++j)
+          acc[j] = red.reduce(acc[j]);
+      }
+      T* c_row = c + i * m;
+      for (std::size_t j = 0; j < m; ++j)
+        c_row[j] = static_cast<T>(acc[j]);
+    }
+  });
+}
+
+}  // namespace kernels
+}  // namespace linmath
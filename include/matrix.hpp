@@ -2,6 +2,7 @@
 
 #include <algorithm>
 #include <concepts>
+#include <cstdint>
 #include <functional>
 #include <initializer_list>
 #include <iostream>
@@ -9,6 +10,7 @@
 #include <limits>
 #include <optional>
 #include <stdexcept>
+#include <utility>
 #include "iterator.hpp"
 #include "shell_matrix.hpp"
 #include "vector.hpp"
@@ -21,6 +23,7 @@ class matrix {
 
  public:
   using it = iterator::myIterator<T>;
+  using const_it = iterator::myIterator<const T>;
 
   matrix(std::size_t rows, std::size_t cols, T val = T{})
       : m_shell_matrix{rows, cols, val} {
@@ -41,6 +44,34 @@ class matrix {
     reserve_rows_vec();
   }
 
+  // Row pointers are rebuilt against the new buffer, keeping any row
+  // permutation; small buffers live inside the object and move with it
+  matrix(const matrix& rhs)
+      : m_shell_matrix{rhs.m_shell_matrix}, m_rows_vec{rhs.m_rows_vec} {
+    rebase_rows(rhs.m_shell_matrix.data());
+  }
+
+  matrix(matrix&& rhs) noexcept
+      : matrix{std::move(rhs), std::as_const(rhs.m_shell_matrix).data()} {}
+
+  matrix& operator=(const matrix& rhs) {
+    if (this == std::addressof(rhs))
+      return *this;
+    matrix tmp{rhs};
+    *this = std::move(tmp);
+    return *this;
+  }
+
+  matrix& operator=(matrix&& rhs) noexcept {
+    if (this == std::addressof(rhs))
+      return *this;
+    const T* old_base = std::as_const(rhs.m_shell_matrix).data();
+    m_shell_matrix = std::move(rhs.m_shell_matrix);
+    m_rows_vec = std::move(rhs.m_rows_vec);
+    rebase_rows(old_base);
+    return *this;
+  }
+
   static matrix zero(std::size_t rows, std::size_t cols) {
     return matrix<T>{rows, cols};
   }
@@ -58,12 +89,25 @@ class matrix {
     std::size_t n_cols = ncols();
     std::size_t n_rows = nrows();
 
+    m_rows_vec.clear();
     m_rows_vec.reserve(n_rows);
     for (std::size_t idx = 0; idx != n_rows; ++idx) {
-      m_rows_vec[idx] = m_shell_matrix.data() + idx * n_cols;
+      m_rows_vec.push_back(m_shell_matrix.data() + idx * n_cols);
     }
   }
 
+  matrix(matrix&& rhs, const T* old_base) noexcept
+      : m_shell_matrix{std::move(rhs.m_shell_matrix)},
+        m_rows_vec{std::move(rhs.m_rows_vec)} {
+    rebase_rows(old_base);
+  }
+
+  void rebase_rows(const T* old_base) {
+    T* base = m_shell_matrix.data();
+    for (std::size_t idx = 0; idx != m_rows_vec.size(); ++idx)
+      m_rows_vec[idx] = base + (m_rows_vec[idx] - old_base);
+  }
+
   class proxy_row {
    private:
     T* row_ptr = nullptr;
@@ -109,28 +153,60 @@ class matrix {
     return const_proxy_row{m_rows_vec[idx], ncols()};
   }
 
+  // The shell matrix operators replace the buffer, so the row table is
+  // rebuilt after each of them
   matrix& operator*=(T value) {
     m_shell_matrix *= value;
+    reserve_rows_vec();
     return *this;
   }
 
   matrix& operator/=(T value) {
     m_shell_matrix /= value;
+    reserve_rows_vec();
     return *this;
   }
 
   matrix& operator+=(const matrix& rhs) {
     m_shell_matrix += rhs.m_shell_matrix;
+    reserve_rows_vec();
     return *this;
   }
 
   matrix& operator-=(const matrix& rhs) {
     m_shell_matrix -= rhs.m_shell_matrix;
+    reserve_rows_vec();
     return *this;
   }
 
   matrix& operator*=(const matrix& rhs) {
     m_shell_matrix *= rhs.m_shell_matrix;
+    reserve_rows_vec();
+    return *this;
+  }
+
+  matrix pow(std::uint64_t k) const { return matrix{m_shell_matrix.pow(k)}; }
+
+  matrix pow_mod(std::uint64_t k, std::uint64_t mod) const
+      requires std::is_integral_v<T> {
+    return matrix{m_shell_matrix.pow_mod(k, mod)};
+  }
+
+  template <typename F>
+  matrix transform(F fn) const {
+    return matrix{m_shell_matrix.transform(fn)};
+  }
+
+  template <typename F, typename... Others>
+    requires(std::same_as<Others, matrix> && ...)
+  matrix zip_with(F fn, const Others&... others) const {
+    return matrix{m_shell_matrix.zip_with(fn, others.m_shell_matrix...)};
+  }
+
+  template <typename F, typename... Others>
+    requires(std::same_as<Others, matrix> && ...)
+  matrix& apply_inplace(F fn, const Others&... others) {
+    m_shell_matrix.apply_inplace(fn, others.m_shell_matrix...);
     return *this;
   }
 
@@ -271,8 +347,10 @@ class matrix {
 
   bool square() const { return nrows() == ncols(); }
 
-  it begin() const { return m_shell_matrix.begin(); }
-  it end() const { return m_shell_matrix.end(); }
+  it begin() { return m_shell_matrix.begin(); }
+  it end() { return m_shell_matrix.end(); }
+  const_it begin() const { return m_shell_matrix.begin(); }
+  const_it end() const { return m_shell_matrix.end(); }
 };
 
 // clang-format off
@@ -0,0 +1,262 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace parallel {
+
+class thread_pool final {
+  std::vector<std::thread> m_workers;
+  // Tasks any worker may take, and tasks pinned to one worker
+  std::queue<std::function<void()>> m_tasks;
+  std::vector<std::queue<std::function<void()>>> m_pinned;
+  std::mutex m_mutex;
+  std::condition_variable m_cv;
+  bool m_stop = false;
+
+  static inline thread_local bool tls_worker = false;
+
+  void worker_loop(std::size_t idx) {
+    tls_worker = true;
+    auto& own = m_pinned[idx];
+    for (;;) {
+      std::function<void()> task;
+      {
+        std::unique_lock<std::mutex> lock{m_mutex};
+        m_cv.wait(lock, [this, &own] {
+          return m_stop || !own.empty() || !m_tasks.empty();
+        });
+        auto& queue = own.empty() ? m_tasks : own;
+        if (queue.empty())
+          return;
+        task = std::move(queue.front());
+        queue.pop();
+      }
+      task();
+    }
+  }
+
+  template <typename F>
+  auto enqueue(std::queue<std::function<void()>>& queue, F&& fn)
+      -> std::future<std::invoke_result_t<F>> {
+    using ret_t = std::invoke_result_t<F>;
+    auto task =
+        std::make_shared<std::packaged_task<ret_t()>>(std::forward<F>(fn));
+    auto fut = task->get_future();
+    std::lock_guard<std::mutex> lock{m_mutex};
+    if (m_stop)
+      throw std::runtime_error("Submit to stopped thread pool");
+    queue.emplace([task] { (*task)(); });
+    return fut;
+  }
+
+ public:
+  explicit thread_pool(
+      std::size_t n_threads = std::thread::hardware_concurrency()) {
+    n_threads = std::max<std::size_t>(n_threads, 1);
+    m_pinned.resize(n_threads);
+    m_workers.reserve(n_threads);
+    for (std::size_t i = 0; i != n_threads; ++i)
+      m_workers.emplace_back([this, i] { worker_loop(i); });
+  }
+
+  thread_pool(const thread_pool&) = delete;
+  thread_pool& operator=(const thread_pool&) = delete;
+
+  ~thread_pool() {
+    {
+      std::lock_guard<std::mutex> lock{m_mutex};
+      m_stop = true;
+    }
+    m_cv.notify_all();
+    for (auto& worker : m_workers)
+      worker.join();
+  }
+
+  template <typename F>
+  auto submit(F&& fn) -> std::future<std::invoke_result_t<F>> {
+    auto fut = enqueue(m_tasks, std::forward<F>(fn));
+    m_cv.notify_one();
+    return fut;
+  }
+
+  // Runs fn on the given worker, so repeated calls with the same index
+  // always touch memory from the same thread
+  template <typename F>
+  auto submit_to(std::size_t worker, F&& fn)
+      -> std::future<std::invoke_result_t<F>> {
+    auto fut = enqueue(m_pinned[worker % size()], std::forward<F>(fn));
+    m_cv.notify_all();
+    return fut;
+  }
+
+  std::size_t size() const noexcept { return m_workers.size(); }
+
+  // Nested parallel regions run serially on workers to avoid waiting on
+  // tasks queued behind the caller.
+  static bool in_worker() noexcept { return tls_worker; }
+};
+
+namespace detail {
+
+inline std::atomic<thread_pool*>& pool_override() {
+  static std::atomic<thread_pool*> pool{nullptr};
+  return pool;
+}
+
+inline std::atomic<bool>& deterministic_flag() {
+  static std::atomic<bool> flag{std::getenv("LINMATH_DETERMINISTIC") !=
+                                nullptr};
+  return flag;
+}
+
+}  // namespace detail
+
+inline thread_pool& default_pool() {
+  if (thread_pool* pool = detail::pool_override().load())
+    return *pool;
+  static thread_pool pool{};
+  return pool;
+}
+
+// Routes every parallel region to pool while alive
+class pool_scope final {
+  thread_pool* m_prev;
+
+ public:
+  explicit pool_scope(thread_pool& pool)
+      : m_prev{detail::pool_override().exchange(&pool)} {}
+  pool_scope(const pool_scope&) = delete;
+  pool_scope& operator=(const pool_scope&) = delete;
+  ~pool_scope() { detail::pool_override().store(m_prev); }
+};
+
+// In deterministic mode chunk boundaries depend only on the problem size and
+// reductions merge fixed-size blocks in a fixed order, so floating-point
+// results are bitwise identical for any number of threads. Also enabled by
+// setting LINMATH_DETERMINISTIC in the environment.
+inline bool deterministic() {
+  return detail::deterministic_flag().load(std::memory_order_relaxed);
+}
+
+inline void set_deterministic(bool on) {
+  detail::deterministic_flag().store(on, std::memory_order_relaxed);
+}
+
+class deterministic_scope final {
+  bool m_prev;
+
+ public:
+  explicit deterministic_scope(bool on = true) : m_prev{deterministic()} {
+    set_deterministic(on);
+  }
+  deterministic_scope(const deterministic_scope&) = delete;
+  deterministic_scope& operator=(const deterministic_scope&) = delete;
+  ~deterministic_scope() { set_deterministic(m_prev); }
+};
+
+// Chunks per region in deterministic mode, whatever the pool size
+static constexpr std::size_t deterministic_chunks = 64;
+// Elements per partial result of a deterministic reduction
+static constexpr std::size_t reduce_block = 4096;
+
+// Splits [0, count) into contiguous chunks of at least grain elements and
+// calls fn(begin, end) for each of them. The first chunk runs on the caller
+// and chunk i on worker i - 1, so equal splits land on the same threads.
+// In deterministic mode the chunks do not depend on the pool size; the
+// caller and the workers each take a contiguous run of them, so equal
+// splits still land on the same threads. Callers must not rely on the
+// boundaries beyond that: nested regions run as one chunk.
+template <typename F>
+void for_each_chunk(std::size_t count, std::size_t grain, F&& fn) {
+  if (count == 0)
+    return;
+
+  thread_pool& pool = default_pool();
+  grain = std::max<std::size_t>(grain, 1);
+  const bool fixed = deterministic();
+  std::size_t n_chunks = std::min(fixed ? deterministic_chunks : pool.size(),
+                                  (count + grain - 1) / grain);
+  if (n_chunks <= 1 || thread_pool::in_worker()) {
+    fn(std::size_t{0}, count);
+    return;
+  }
+  const std::size_t n_threads = std::min(pool.size(), n_chunks);
+
+  // start of part idx when total is cut into parts near-equal parts
+  auto bound = [](std::size_t total, std::size_t parts, std::size_t idx) {
+    return idx * (total / parts) + std::min(idx, total % parts);
+  };
+  // thread t takes a contiguous run of chunks
+  auto run = [&](std::size_t t) {
+    const std::size_t lst = bound(n_chunks, n_threads, t + 1);
+    for (std::size_t idx = bound(n_chunks, n_threads, t); idx != lst; ++idx)
+      fn(bound(count, n_chunks, idx), bound(count, n_chunks, idx + 1));
+  };
+
+  std::vector<std::future<void>> pending;
+  pending.reserve(n_threads - 1);
+  for (std::size_t t = 1; t != n_threads; ++t)
+    pending.push_back(pool.submit_to(t - 1, [&run, t] { run(t); }));
+  std::exception_ptr error;
+  try {
+    run(0);
+  } catch (...) {
+    error = std::current_exception();
+  }
+  // every chunk must finish before fn goes out of scope
+  for (auto& fut : pending) {
+    try {
+      fut.get();
+    } catch (...) {
+      if (!error)
+        error = std::current_exception();
+    }
+  }
+  if (error)
+    std::rethrow_exception(error);
+}
+
+// Reduces [0, count): block(begin, end) returns the partial result of one
+// range and combine(lhs, rhs) merges two partials. Partials are merged
+// pairwise in block order. Blocks hold reduce_block elements in
+// deterministic mode, otherwise one block per thread.
+template <typename R, typename Block, typename Combine>
+R reduce(std::size_t count, R init, Block&& block, Combine&& combine) {
+  if (count == 0)
+    return init;
+
+  std::size_t block_size = reduce_block;
+  if (!deterministic()) {
+    std::size_t per_thread = (count + default_pool().size() - 1) /
+                             default_pool().size();
+    block_size = std::max(block_size, per_thread);
+  }
+  const std::size_t n_blocks = (count + block_size - 1) / block_size;
+
+  std::vector<R> partial(n_blocks, init);
+  for_each_chunk(n_blocks, 1, [&](std::size_t frst, std::size_t lst) {
+    for (std::size_t idx = frst; idx != lst; ++idx)
+      partial[idx] = block(idx * block_size,
+                           std::min(count, (idx + 1) * block_size));
+  });
+  for (std::size_t width = 1; width < n_blocks; width *= 2)
+    for (std::size_t idx = 0; idx + width < n_blocks; idx += 2 * width)
+      partial[idx] = combine(partial[idx], partial[idx + width]);
+  return combine(init, partial[0]);
+}
+
+}  // namespace parallel
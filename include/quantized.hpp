@@ -0,0 +1,247 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <concepts>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include "kernels.hpp"
+#include "shell_matrix.hpp"
+#include "simd.hpp"
+#include "vector.hpp"
+
+namespace linmath {
+
+template <typename Q>
+concept quantized_type =
+    std::same_as<Q, std::int8_t> || std::same_as<Q, std::int16_t>;
+
+enum class quant_axis { rows, cols };
+
+// Products are accumulated in int32 for int8 inputs; int16 products of
+// full-range values overflow int32 after a couple of terms, so they are
+// accumulated in int64
+template <quantized_type Q>
+using accumulator_t =
+    std::conditional_t<std::same_as<Q, std::int8_t>, std::int32_t,
+                       std::int64_t>;
+
+// Symmetric quantization: element (i, j) ~ q(i, j) * scales[i] for
+// quant_axis::rows and q(i, j) * scales[j] for quant_axis::cols.
+// Quantized values stay within [-max, max] of Q, never at its minimum.
+template <quantized_type Q>
+struct quantized_matrix {
+  shell_matrix<Q> values;
+  containers::vector<float> scales;
+  quant_axis axis = quant_axis::rows;
+};
+
+namespace kernels {
+namespace detail {
+
+template <quantized_type Q>
+accumulator_t<Q> dot_scalar(const Q* a, const Q* b, std::size_t k) {
+  accumulator_t<Q> acc = 0;
+  for (std::size_t p = 0; p < k; ++p)
+    acc += static_cast<std::int32_t>(a[p]) * static_cast<std::int32_t>(b[p]);
+  return acc;
+}
+
+#ifdef LINMATH_X86_DISPATCH
+__attribute__((target("avx2"))) inline std::int32_t hsum_epi32(__m256i v) {
+  __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(v),
+                              _mm256_extracti128_si256(v, 1));
+  sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4e));
+  sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xb1));
+  return _mm_cvtsi128_si32(sum);
+}
+
+__attribute__((target("avx2"))) inline std::int64_t hsum_epi64(__m256i v) {
+  __m128i sum = _mm_add_epi64(_mm256_castsi256_si128(v),
+                              _mm256_extracti128_si256(v, 1));
+  sum = _mm_add_epi64(sum, _mm_unpackhi_epi64(sum, sum));
+  return _mm_cvtsi128_si64(sum);
+}
+
+// pmaddubsw multiplies unsigned by signed bytes, so |a| is paired with
+// b * sign(a). Requires b != -128, which gemm_quantized() checks.
+__attribute__((target("avx2"))) inline std::int32_t dot_s8_avx2(
+    const std::int8_t* a, const std::int8_t* b, std::size_t k) {
+  const __m256i ones = _mm256_set1_epi16(1);
+  __m256i acc = _mm256_setzero_si256();
+  std::size_t p = 0;
+  for (; p + 32 <= k; p += 32) {
+    __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + p));
+    __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + p));
+    __m256i pairs = _mm256_maddubs_epi16(_mm256_sign_epi8(va, va),
+                                         _mm256_sign_epi8(vb, va));
+    acc = _mm256_add_epi32(acc, _mm256_madd_epi16(pairs, ones));
+  }
+  return hsum_epi32(acc) + dot_scalar(a + p, b + p, k - p);
+}
+
+__attribute__((target("avx2,avx512vl,avx512vnni"))) inline std::int32_t
+dot_s8_vnni(const std::int8_t* a, const std::int8_t* b, std::size_t k) {
+  __m256i acc = _mm256_setzero_si256();
+  std::size_t p = 0;
+  for (; p + 32 <= k; p += 32) {
+    __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + p));
+    __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + p));
+    acc = _mm256_dpbusd_epi32(acc, _mm256_sign_epi8(va, va),
+                              _mm256_sign_epi8(vb, va));
+  }
+  return hsum_epi32(acc) + dot_scalar(a + p, b + p, k - p);
+}
+
+// pmaddwd pair sums fit in int32 for |values| <= 32767 and are widened to
+// int64 lanes before accumulation
+__attribute__((target("avx2"))) inline std::int64_t dot_s16_avx2(
+    const std::int16_t* a, const std::int16_t* b, std::size_t k) {
+  __m256i acc = _mm256_setzero_si256();
+  std::size_t p = 0;
+  for (; p + 16 <= k; p += 16) {
+    __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + p));
+    __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + p));
+    __m256i pairs = _mm256_madd_epi16(va, vb);
+    acc = _mm256_add_epi64(
+        acc, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(pairs)));
+    acc = _mm256_add_epi64(
+        acc, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(pairs, 1)));
+  }
+  return hsum_epi64(acc) + dot_scalar(a + p, b + p, k - p);
+}
+#endif
+
+template <quantized_type Q>
+accumulator_t<Q> dot(const Q* a, const Q* b, std::size_t k,
+                     simd::isa level) {
+#ifdef LINMATH_X86_DISPATCH
+  if constexpr (std::same_as<Q, std::int8_t>) {
+    if (level == simd::isa::avx512_vnni)
+      return dot_s8_vnni(a, b, k);
+    if (level == simd::isa::avx2)
+      return dot_s8_avx2(a, b, k);
+  } else {
+    if (level != simd::isa::scalar)
+      return dot_s16_avx2(a, b, k);
+  }
+#endif
+  return dot_scalar(a, b, k);
+}
+
+}  // namespace detail
+
+// C[n x m] = A[n x k] * B[k x m] in the accumulator type; bt holds B
+// transposed (m x k) so both operands of every dot product are contiguous.
+// Entries must lie in [-max, max] of Q like quantize() output: the minimum
+// of Q overflows the sign trick of the int8 kernels and the pair sums of
+// the int16 kernel, so it is rejected before any ISA is chosen.
+template <quantized_type Q>
+void gemm_quantized(const Q* a, const Q* bt, accumulator_t<Q>* c,
+                    std::size_t n, std::size_t k, std::size_t m,
+                    simd::isa level = params().quantized_isa) {
+  constexpr Q qmin = std::numeric_limits<Q>::min();
+  if (std::find(a, a + n * k, qmin) != a + n * k ||
+      std::find(bt, bt + m * k, qmin) != bt + m * k)
+    throw std::invalid_argument("Quantized values must lie in [-max, max]");
+
+  constexpr std::size_t tile = 64;
+  detail::split_rows(n, k * m, [=](std::size_t row_frst, std::size_t row_lst) {
+    for (std::size_t jj = 0; jj < m; jj += tile) {
+      std::size_t j_lst = std::min(jj + tile, m);
+      for (std::size_t i = row_frst; i < row_lst; ++i)
+        for (std::size_t j = jj; j < j_lst; ++j)
+          c[i * m + j] = detail::dot(a + i * k, bt + j * k, k, level);
+    }
+  });
+}
+
+}  // namespace kernels
+
+template <quantized_type Q>
+quantized_matrix<Q> quantize(const shell_matrix<float>& src,
+                             quant_axis axis = quant_axis::rows) {
+  constexpr float qmax = std::numeric_limits<Q>::max();
+  const std::size_t n_rows = src.nrows();
+  const std::size_t n_cols = src.ncols();
+  const std::size_t n_scales = axis == quant_axis::rows ? n_rows : n_cols;
+
+  containers::vector<float> scales(n_scales);
+  for (std::size_t i = 0; i < n_rows; ++i)
+    for (std::size_t j = 0; j < n_cols; ++j) {
+      float& s = scales[axis == quant_axis::rows ? i : j];
+      s = std::max(s, std::abs(src[i][j]));
+    }
+  for (std::size_t idx = 0; idx < n_scales; ++idx)
+    scales[idx] = scales[idx] > 0 ? scales[idx] / qmax : 1.0f;
+
+  shell_matrix<Q> values{n_rows, n_cols};
+  for (std::size_t i = 0; i < n_rows; ++i)
+    for (std::size_t j = 0; j < n_cols; ++j) {
+      float s = scales[axis == quant_axis::rows ? i : j];
+      float q = std::clamp(std::nearbyint(src[i][j] / s), -qmax, qmax);
+      values[i][j] = static_cast<Q>(q);
+    }
+  return quantized_matrix<Q>{std::move(values), std::move(scales), axis};
+}
+
+template <quantized_type Q>
+shell_matrix<float> dequantize(const quantized_matrix<Q>& src) {
+  const std::size_t n_rows = src.values.nrows();
+  const std::size_t n_cols = src.values.ncols();
+  shell_matrix<float> ret{n_rows, n_cols};
+  for (std::size_t i = 0; i < n_rows; ++i)
+    for (std::size_t j = 0; j < n_cols; ++j) {
+      float s = src.scales[src.axis == quant_axis::rows ? i : j];
+      ret[i][j] = static_cast<float>(src.values[i][j]) * s;
+    }
+  return ret;
+}
+
+// Exact integer product of two quantized matrices
+template <quantized_type Q>
+shell_matrix<accumulator_t<Q>> multiply_raw(const shell_matrix<Q>& lhs,
+                                            const shell_matrix<Q>& rhs) {
+  if (lhs.ncols() != rhs.nrows())
+    throw std::runtime_error("Unsuitable matrix sizes");
+
+  const std::size_t n = lhs.nrows();
+  const std::size_t k = lhs.ncols();
+  const std::size_t m = rhs.ncols();
+  shell_matrix<Q> bt{m, k};
+  for (std::size_t p = 0; p < k; ++p)
+    for (std::size_t j = 0; j < m; ++j)
+      bt[j][p] = rhs[p][j];
+
+  shell_matrix<accumulator_t<Q>> ret{n, m};
+  kernels::gemm_quantized(lhs.data(), bt.data(), ret.data(), n, k, m);
+  return ret;
+}
+
+// lhs must be quantized per row and rhs per column, so every output
+// element is rescaled by one row and one column factor
+template <quantized_type Q>
+shell_matrix<float> multiply(const quantized_matrix<Q>& lhs,
+                             const quantized_matrix<Q>& rhs) {
+  if (lhs.axis != quant_axis::rows || rhs.axis != quant_axis::cols)
+    throw std::invalid_argument("Unsuitable quantization axes");
+
+  shell_matrix<accumulator_t<Q>> raw = multiply_raw(lhs.values, rhs.values);
+  shell_matrix<float> ret{raw.nrows(), raw.ncols()};
+  for (std::size_t i = 0; i < raw.nrows(); ++i)
+    for (std::size_t j = 0; j < raw.ncols(); ++j)
+      ret[i][j] = static_cast<float>(raw[i][j]) * lhs.scales[i] *
+                  rhs.scales[j];
+  return ret;
+}
+
+template <quantized_type Q>
+shell_matrix<float> quantized_multiply(const shell_matrix<float>& lhs,
+                                       const shell_matrix<float>& rhs) {
+  return multiply(quantize<Q>(lhs, quant_axis::rows),
+                  quantize<Q>(rhs, quant_axis::cols));
+}
+
+}  // namespace linmath
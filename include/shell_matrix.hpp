@@ -1,15 +1,24 @@
 #pragma once
 
 #include <algorithm>
+#include <bit>
+#include <cmath>
 #include <concepts>
+#include <cstdint>
 #include <functional>
 #include <initializer_list>
 #include <iostream>
 #include <iterator>
 #include <limits>
 #include <optional>
+#include <ranges>
+#include <span>
 #include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include "cow_vector.hpp"
 #include "iterator.hpp"
+#include "kernels.hpp"
 #include "vector.hpp"
 
 namespace linmath {
@@ -20,25 +29,92 @@ struct default_precision {
   static constexpr T prec = 1.0e-6f;
 };
 
-template <typename T>
+// Buffer selects the storage: containers::vector owns its elements,
+// containers::cow_vector shares them between copies until one is modified
+template <typename T, typename Buffer = containers::vector<T>>
 class shell_matrix final {
   std::size_t n_rows = 0;
   std::size_t n_cols = 0;
 
-  containers::vector<T> m_buffer;
+  Buffer m_buffer;
+
+  // Plain element types are filled by kernels::fill, which splits large
+  // matrices across the pool the same way the row-parallel kernels do
+  static constexpr bool parallel_init = std::is_trivially_copyable_v<T>;
+
+  static Buffer filled(std::size_t rows, std::size_t cols, const T& val) {
+    if constexpr (parallel_init) {
+      Buffer buf{rows * cols, containers::uninitialized};
+      kernels::fill(buf.data(), rows, cols, val);
+      return buf;
+    } else {
+      return Buffer{rows * cols, val};
+    }
+  }
+
+  // Shared buffers are not copied at all
+  static Buffer copied(const shell_matrix& rhs) {
+    if constexpr (parallel_init &&
+                  std::is_same_v<Buffer, containers::vector<T>>) {
+      Buffer buf{rhs.n_rows * rhs.n_cols, containers::uninitialized};
+      kernels::copy(rhs.data(), buf.data(), rhs.n_rows, rhs.n_cols);
+      return buf;
+    } else {
+      return rhs.m_buffer;
+    }
+  }
 
  public:
   using it = iterator::myIterator<T>;
+  using const_it = iterator::myIterator<const T>;
 
   shell_matrix(std::size_t rows, std::size_t cols, T val = T{})
-      : n_rows{rows}, n_cols{cols}, m_buffer{rows * cols, val} {}
+      : n_rows{rows}, n_cols{cols}, m_buffer{filled(rows, cols, val)} {}
+
+  // Storage is left uninitialized, for results that are written in full
+  shell_matrix(std::size_t rows, std::size_t cols, containers::uninitialized_t)
+    requires parallel_init
+      : n_rows{rows},
+        n_cols{cols},
+        m_buffer{rows * cols, containers::uninitialized} {}
+
+  shell_matrix(const shell_matrix& rhs)
+      : n_rows{rhs.n_rows}, n_cols{rhs.n_cols}, m_buffer{copied(rhs)} {}
+
+  // The source is left as an empty 0 x 0 matrix
+  shell_matrix(shell_matrix&& rhs) noexcept
+      : n_rows{std::exchange(rhs.n_rows, 0)},
+        n_cols{std::exchange(rhs.n_cols, 0)},
+        m_buffer{std::move(rhs.m_buffer)} {}
+
+  shell_matrix& operator=(const shell_matrix& rhs) {
+    if (this == std::addressof(rhs))
+      return *this;
+    shell_matrix tmp{rhs};
+    *this = std::move(tmp);
+    return *this;
+  }
+
+  shell_matrix& operator=(shell_matrix&& rhs) noexcept {
+    if (this == std::addressof(rhs))
+      return *this;
+    n_rows = std::exchange(rhs.n_rows, 0);
+    n_cols = std::exchange(rhs.n_cols, 0);
+    m_buffer = std::move(rhs.m_buffer);
+    return *this;
+  }
 
   template <typename iter>
   shell_matrix(std::size_t rows, std::size_t cols, iter frst, iter lst)
       : shell_matrix{rows, cols} {
     std::size_t count = rows * cols;
-    std::copy_if(frst, lst, m_buffer.begin(),
-                 [&count](const auto&) { return count && count--; });
+    if constexpr (std::random_access_iterator<iter>) {
+      count = std::min<std::size_t>(count, lst - frst);
+      std::copy_n(frst, count, data());
+    } else {
+      for (T* out = data(); count && frst != lst; --count, ++frst)
+        *out++ = *frst;
+    }
   }
 
   shell_matrix(std::size_t rows, std::size_t cols,
@@ -116,12 +192,18 @@ class shell_matrix final {
     if ((n_rows != rhs.n_rows) || (n_cols != rhs.n_cols))
       throw std::runtime_error("Unsuitable matrix sizes");
 
-    shell_matrix tmp{n_rows, n_cols, begin(), end()};
-    for (std::size_t i = 0; i < n_rows; ++i) {
-      for (std::size_t j = 0; j < n_cols; ++j)
-        tmp[i][j] += rhs[i][j];
+    if constexpr (is_widened_v<T>) {
+      kernels::elementwise_widened(data(), rhs.data(), n_rows * n_cols,
+                                   std::plus<>{});
+      return *this;
     }
-    *this = std::move(tmp);
+
+    // data() detaches a shared buffer first, so rhs keeps its values even
+    // when it shares storage with *this
+    T* dst = data();
+    const T* src = rhs.data();
+    for (std::size_t idx = 0, count = n_rows * n_cols; idx != count; ++idx)
+      dst[idx] += src[idx];
     return *this;
   }
 
@@ -129,22 +211,32 @@ class shell_matrix final {
     if ((n_rows != rhs.n_rows) || (n_cols != rhs.n_cols))
       throw std::runtime_error("Unsuitable matrix sizes");
 
-    shell_matrix tmp{n_rows, n_cols, begin(), end()};
-    for (std::size_t i = 0; i < n_rows; ++i) {
-      for (std::size_t j = 0; j < n_cols; ++j)
-        tmp[i][j] -= rhs[i][j];
+    if constexpr (is_widened_v<T>) {
+      kernels::elementwise_widened(data(), rhs.data(), n_rows * n_cols,
+                                   std::minus<>{});
+      return *this;
     }
-    *this = std::move(tmp);
+
+    // data() detaches a shared buffer first, so rhs keeps its values even
+    // when it shares storage with *this
+    T* dst = data();
+    const T* src = rhs.data();
+    for (std::size_t idx = 0, count = n_rows * n_cols; idx != count; ++idx)
+      dst[idx] -= src[idx];
     return *this;
   }
 
   shell_matrix& operator*=(const T rhs) {
-    shell_matrix tmp{n_rows, n_cols, begin(), end()};
-    for (std::size_t i = 0; i < n_rows; ++i) {
-      for (std::size_t j = 0; j < n_cols; ++j)
-        tmp[i][j] *= rhs;
+    if constexpr (is_widened_v<T>) {
+      const compute_t<T> val = rhs;
+      kernels::elementwise_widened(data(), n_rows * n_cols,
+                                   [val](auto x) { return x * val; });
+      return *this;
     }
-    *this = std::move(tmp);
+
+    T* dst = data();
+    for (std::size_t idx = 0, count = n_rows * n_cols; idx != count; ++idx)
+      dst[idx] *= rhs;
     return *this;
   }
 
@@ -152,12 +244,16 @@ class shell_matrix final {
     if (rhs == 0)
       throw std::invalid_argument("Division by zero");
 
-    shell_matrix tmp{n_rows, n_cols, begin(), end()};
-    for (std::size_t i = 0; i < n_rows; ++i) {
-      for (std::size_t j = 0; j < n_cols; ++j)
-        tmp[i][j] /= rhs;
+    if constexpr (is_widened_v<T>) {
+      const compute_t<T> val = rhs;
+      kernels::elementwise_widened(data(), n_rows * n_cols,
+                                   [val](auto x) { return x / val; });
+      return *this;
     }
-    *this = std::move(tmp);
+
+    T* dst = data();
+    for (std::size_t idx = 0, count = n_rows * n_cols; idx != count; ++idx)
+      dst[idx] /= rhs;
     return *this;
   }
 
@@ -166,15 +262,136 @@ class shell_matrix final {
     if (n_cols != rhs.n_rows)
       throw std::runtime_error("Unsuitable matrix sizes");
 
-    shell_matrix tmp{n_rows, n_cols, begin(), end()};
-    for (std::size_t k = 0; k < n_cols; ++k) {
-      for (std::size_t i = 0; i < n_rows; ++i) {
-        auto r = (*this)[i][k];
-        for (std::size_t j = 0; j < rhs.n_cols; ++j)
-          tmp[i][j] = r * rhs[k][j];
+    shell_matrix tmp{n_rows, rhs.n_cols};
+    kernels::gemm(std::as_const(*this).data(), rhs.data(), tmp.data(), n_rows,
+                  n_cols, rhs.n_cols);
+    *this = std::move(tmp);
+    return *this;
+  }
+
+ private:
+  // Left-to-right binary exponentiation over two preallocated buffers:
+  // mult(a, b, c) overwrites c with a * b, the result and the scratch
+  // matrix swap roles after every product and base is only read.
+  template <typename Mult>
+  shell_matrix power(const T* base, std::uint64_t k, Mult mult) const {
+    shell_matrix res{n_rows, n_cols, base, base + n_rows * n_cols};
+    shell_matrix tmp = same_shape();
+    const int top = static_cast<int>(std::bit_width(k)) - 1;
+    for (int bit = top - 1; bit >= 0; --bit) {
+      mult(std::as_const(res).data(), std::as_const(res).data(), tmp.data());
+      std::swap(res.m_buffer, tmp.m_buffer);
+      if ((k >> bit) & 1) {
+        mult(std::as_const(res).data(), base, tmp.data());
+        std::swap(res.m_buffer, tmp.m_buffer);
       }
     }
-    *this = std::move(tmp);
+    return res;
+  }
+
+ public:
+  shell_matrix pow(std::uint64_t k) const {
+    if (!square())
+      throw std::runtime_error("Unsuitable matrix size for power");
+    if (k == 0)
+      return identity(n_rows);
+
+    std::size_t sz = n_rows;
+    return power(data(), k, [sz](const T* a, const T* b, T* c) {
+      // c holds live elements here, only plain types may be refilled raw
+      if constexpr (parallel_init)
+        kernels::fill(c, sz, sz, T{});
+      else
+        std::fill_n(c, sz * sz, T{});
+      kernels::gemm(a, b, c, sz, sz, sz);
+    });
+  }
+
+  // Power with every entry reduced modulo mod (mod < 2^32), the reduction
+  // runs inside the multiply kernel. Entries outside [0, mod) are reduced
+  // into a copy first.
+  shell_matrix pow_mod(std::uint64_t k, std::uint64_t mod) const
+      requires std::is_integral_v<T> {
+    if (!square())
+      throw std::runtime_error("Unsuitable matrix size for power");
+    if (mod == 0 || mod > (std::uint64_t{1} << 32) ||
+        mod - 1 > static_cast<std::uint64_t>(std::numeric_limits<T>::max()))
+      throw std::invalid_argument("Unsuitable modulus");
+
+    if (k == 0)
+      return mod == 1 ? zero(n_rows, n_cols) : identity(n_rows);
+
+    const std::size_t count = n_rows * n_cols;
+    const T* src = data();
+    auto reduced = [mod](T val) {
+      return val >= T{} && static_cast<std::uint64_t>(val) < mod;
+    };
+    std::optional<shell_matrix> base;
+    if (!std::all_of(src, src + count, reduced)) {
+      const auto smod = static_cast<std::int64_t>(mod);
+      base.emplace(same_shape());
+      for (std::size_t idx = 0; idx != count; ++idx) {
+        auto rem = static_cast<std::int64_t>(src[idx] % smod);
+        base->m_buffer[idx] = static_cast<T>(rem < 0 ? rem + smod : rem);
+      }
+      src = std::as_const(*base).data();
+    }
+
+    std::size_t sz = n_rows;
+    kernels::barrett_reducer red{mod};
+    return power(src, k, [sz, &red](const T* a, const T* b, T* c) {
+      kernels::gemm_mod(a, b, c, sz, sz, sz, red);
+    });
+  }
+
+ private:
+  template <typename... Others>
+  void check_same_shape(const Others&... others) const {
+    if (((others.n_rows != n_rows || others.n_cols != n_cols) || ...))
+      throw std::runtime_error("Unsuitable matrix sizes");
+  }
+
+  shell_matrix same_shape() const {
+    if constexpr (parallel_init)
+      return shell_matrix{n_rows, n_cols, containers::uninitialized};
+    else
+      return shell_matrix{n_rows, n_cols};
+  }
+
+ public:
+  // Elementwise maps over the contiguous buffer in one fused pass, split
+  // across the pool for large matrices. fn receives one element of each
+  // operand (as compute_t<T> for narrow storage) and returns the result.
+
+  // ret(i, j) = fn(this(i, j))
+  template <typename F>
+  shell_matrix transform(F fn) const {
+    shell_matrix ret = same_shape();
+    kernels::map(ret.data(), n_rows, n_cols, fn, data());
+    return ret;
+  }
+
+  // ret(i, j) = fn(this(i, j), others(i, j)...) for one or two others
+  template <typename F, typename... Others>
+    requires(sizeof...(Others) >= 1 && sizeof...(Others) <= 2 &&
+             (std::same_as<Others, shell_matrix> && ...))
+  shell_matrix zip_with(F fn, const Others&... others) const {
+    check_same_shape(others...);
+    shell_matrix ret = same_shape();
+    kernels::map(ret.data(), n_rows, n_cols, fn, data(), others.data()...);
+    return ret;
+  }
+
+  // this(i, j) = fn(this(i, j), others(i, j)...) for up to two others,
+  // e.g. y.apply_inplace([a](T y, T x) { return a * x + y; }, x)
+  template <typename F, typename... Others>
+    requires(sizeof...(Others) <= 2 &&
+             (std::same_as<Others, shell_matrix> && ...))
+  shell_matrix& apply_inplace(F fn, const Others&... others) {
+    check_same_shape(others...);
+    T* dst = data();
+    kernels::map(dst, n_rows, n_cols, fn, static_cast<const T*>(dst),
+                 others.data()...);
     return *this;
   }
 
@@ -182,29 +399,33 @@ class shell_matrix final {
   T trace() const {
     if (n_rows != n_cols)
       throw std::runtime_error("Cannot get trace of non-square matrix");
-    T trace{};
-    it leap = begin();
+    compute_t<T> trace{};
+    const_it leap = begin();
     for (std::size_t idx = 0; idx != n_cols; ++idx, leap += n_cols + 1)
       trace += *leap;
-    return trace;
+    return static_cast<T>(trace);
   }
 
-  shell_matrix& transpose() & {
-    static_assert(std::is_nothrow_move_assignable<T>::value);
+  T sum() const {
+    return static_cast<T>(kernels::sum(data(), n_rows * n_cols));
+  }
 
+  // Frobenius norm
+  compute_t<T> norm() const
+    requires std::floating_point<compute_t<T>>
+  {
+    return std::sqrt(kernels::dot(data(), data(), n_rows * n_cols));
+  }
+
+  shell_matrix& transpose() & {
     if (n_rows == n_cols) {
-      for (std::size_t i = 0; i < n_rows; ++i) {
-        for (std::size_t j = 1; j < n_cols; ++j)
-          std::swap((*this)[i][j], (*this)[j][i]);
-      }
+      kernels::transpose_inplace(data(), n_rows);
       return *this;
     }
 
     shell_matrix transposed{n_cols, n_rows};
-    for (std::size_t i = 0; i < n_rows; ++i) {
-      for (std::size_t j = 1; j < n_cols; ++j)
-        transposed[j][i] = std::move((*this)[i][j]);
-    }
+    kernels::transpose(std::as_const(*this).data(), transposed.data(),
+                       n_rows, n_cols);
     *this = std::move(transposed);
     return *this;
   }
@@ -219,8 +440,9 @@ class shell_matrix final {
       return false;
 
     bool answ = true;
-    T precession =
-        std::is_floating_point<T>::value ? default_precision<T>::prec : 0;
+    T precession = std::is_floating_point<compute_t<T>>::value
+                       ? default_precision<T>::prec
+                       : 0;
     for (std::size_t i = 0; i < n_rows; ++i) {
       for (std::size_t j = 0; j < n_cols; ++j)
         answ &= is_equal((*this)[i][j], rhs[i][j], precession);
@@ -229,14 +451,14 @@ class shell_matrix final {
   }
 
   void dump(std::ostream& os) const {
-    os << "n_rows = " << n_rows << std::endl;
-    os << "n_cols = " << n_cols << std::endl;
+    os << "n_rows = " << n_rows << '\n';
+    os << "n_cols = " << n_cols << '\n';
     for (std::size_t i = 0; i < n_rows; ++i) {
       os << "| ";
       for (std::size_t j = 0; j < n_cols; ++j) {
         os << (*this)[i][j] << " ";
       }
-      os << "|" << std::endl;
+      os << "|\n";
     }
   }
 
@@ -247,22 +469,69 @@ class shell_matrix final {
   T* data() { return m_buffer.data(); }
   const T* data() const { return m_buffer.data(); }
 
-  it begin() const { return m_buffer.begin(); }
-  it end() const { return m_buffer.end(); }
+  it begin() { return it{data()}; }
+  it end() { return it{data() + n_rows * n_cols}; }
+  const_it begin() const { return const_it{data()}; }
+  const_it end() const { return const_it{data() + n_rows * n_cols}; }
+
+ private:
+  template <typename U>
+  static auto strided(U* base, std::size_t count, std::size_t stride) {
+    using s_it = iterator::strided_iterator<U>;
+    const auto step = static_cast<std::ptrdiff_t>(stride);
+    return std::ranges::subrange{
+        s_it{base, 0, step}, s_it{base, static_cast<std::ptrdiff_t>(count), step}};
+  }
+
+ public:
+  // Views for std::ranges algorithms: rows are contiguous spans, columns
+  // and the diagonal are random access ranges striding through the buffer
+  std::span<T> row_span(std::size_t i) {
+    return std::span<T>{data() + i * n_cols, n_cols};
+  }
+  std::span<const T> row_span(std::size_t i) const {
+    return std::span<const T>{data() + i * n_cols, n_cols};
+  }
+
+  auto rows() {
+    return std::views::iota(std::size_t{0}, n_rows) |
+           std::views::transform([this](std::size_t i) { return row_span(i); });
+  }
+  auto rows() const {
+    return std::views::iota(std::size_t{0}, n_rows) |
+           std::views::transform([this](std::size_t i) { return row_span(i); });
+  }
+
+  auto column(std::size_t j) { return strided(data() + j, n_rows, n_cols); }
+  auto column(std::size_t j) const {
+    return strided(data() + j, n_rows, n_cols);
+  }
+
+  auto diagonal() {
+    return strided(data(), std::min(n_rows, n_cols), n_cols + 1);
+  }
+  auto diagonal() const {
+    return strided(data(), std::min(n_rows, n_cols), n_cols + 1);
+  }
 };
 
+// Copies share storage until modified through operator[], data(),
+// begin()/end() or a compound operator
+template <typename T>
+using cow_matrix = shell_matrix<T, containers::cow_vector<T>>;
+
 // clang-format off
-template <typename T> shell_matrix<T> operator*(const shell_matrix<T> &lhs, T rhs) { auto res = lhs; res *= rhs; return res; }
-template <typename T> shell_matrix<T> operator*(T lhs, const shell_matrix<T> &rhs) { auto res = rhs; res *= lhs; return res; }
+template <typename T, typename B> shell_matrix<T, B> operator*(const shell_matrix<T, B> &lhs, T rhs) { auto res = lhs; res *= rhs; return res; }
+template <typename T, typename B> shell_matrix<T, B> operator*(T lhs, const shell_matrix<T, B> &rhs) { auto res = rhs; res *= lhs; return res; }
 
-template <typename T> shell_matrix<T> operator+(const shell_matrix<T> &lhs, const shell_matrix<T> &rhs) { auto res = lhs; res += rhs; return res; }
-template <typename T> shell_matrix<T> operator-(const shell_matrix<T> &lhs, const shell_matrix<T> &rhs) { auto res = lhs; res -= rhs; return res; }
+template <typename T, typename B> shell_matrix<T, B> operator+(const shell_matrix<T, B> &lhs, const shell_matrix<T, B> &rhs) { auto res = lhs; res += rhs; return res; }
+template <typename T, typename B> shell_matrix<T, B> operator-(const shell_matrix<T, B> &lhs, const shell_matrix<T, B> &rhs) { auto res = lhs; res -= rhs; return res; }
 
-template <typename T> shell_matrix<T> operator*(const shell_matrix<T> &lhs, const shell_matrix<T> &rhs) { auto res = lhs; res *= rhs; return res; }
-template <typename T> shell_matrix<T> operator/(const shell_matrix<T> &lhs, T rhs) { auto res = lhs; res /= rhs; return res; }
+template <typename T, typename B> shell_matrix<T, B> operator*(const shell_matrix<T, B> &lhs, const shell_matrix<T, B> &rhs) { auto res = lhs; res *= rhs; return res; }
+template <typename T, typename B> shell_matrix<T, B> operator/(const shell_matrix<T, B> &lhs, T rhs) { auto res = lhs; res /= rhs; return res; }
 
-template <typename T> bool operator==(const shell_matrix<T> &lhs, const shell_matrix<T> &rhs) { return lhs.equal(rhs); }
-template <typename T> bool operator!=(const shell_matrix<T> &lhs, const shell_matrix<T> &rhs) { return !(lhs.equal(rhs)); }
+template <typename T, typename B> bool operator==(const shell_matrix<T, B> &lhs, const shell_matrix<T, B> &rhs) { return lhs.equel(rhs); }
+template <typename T, typename B> bool operator!=(const shell_matrix<T, B> &lhs, const shell_matrix<T, B> &rhs) { return !(lhs.equel(rhs)); }
 // clang-format on
 
 }  // namespace linmath
\ No newline at end of file
@@ -0,0 +1,55 @@
+#pragma once
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define LINMATH_X86_DISPATCH 1
+#include <immintrin.h>
+#endif
+
+namespace simd {
+
+// Instruction set levels the kernels are specialised for, in increasing
+// order. Each level implies the ones below it.
+enum class isa { scalar = 0, avx2, avx512_vnni };
+
+inline bool supports(isa level) {
+#ifdef LINMATH_X86_DISPATCH
+  switch (level) {
+    case isa::scalar:
+      return true;
+    case isa::avx2:
+      return __builtin_cpu_supports("avx2");
+    case isa::avx512_vnni:
+      return __builtin_cpu_supports("avx2") &&
+             __builtin_cpu_supports("avx512vl") &&
+             __builtin_cpu_supports("avx512vnni");
+  }
+  return false;
+#else
+  return level == isa::scalar;
+#endif
+}
+
+// Hardware half <-> float conversion, independent of the levels above
+inline bool has_f16c() {
+#ifdef LINMATH_X86_DISPATCH
+  static const bool f16c =
+      __builtin_cpu_supports("avx") && __builtin_cpu_supports("f16c");
+  return f16c;
+#else
+  return false;
+#endif
+}
+
+// Highest level available on this host, detected once
+inline isa best() {
+  static const isa level = [] {
+    if (supports(isa::avx512_vnni))
+      return isa::avx512_vnni;
+    if (supports(isa::avx2))
+      return isa::avx2;
+    return isa::scalar;
+  }();
+  return level;
+}
+
+}  // namespace simd
@@ -0,0 +1,525 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include "kernels.hpp"
+#include "shell_matrix.hpp"
+#include "vector.hpp"
+
+namespace linmath {
+
+// Square n x n matrix with kl sub- and ku superdiagonals. Row i keeps the
+// kl + ku + 1 entries of columns [i - kl, i + ku] contiguously, entries
+// that fall outside the matrix are stored as zero.
+template <typename T>
+class band_matrix final {
+  std::size_t m_size = 0;
+  std::size_t m_lower = 0;
+  std::size_t m_upper = 0;
+
+  containers::vector<T> m_band;
+
+  std::size_t width() const { return m_lower + m_upper + 1; }
+  std::size_t offset(std::size_t i, std::size_t j) const {
+    return i * width() + (j + m_lower - i);
+  }
+
+ public:
+  band_matrix(std::size_t sz, std::size_t kl, std::size_t ku)
+      : m_size{sz},
+        m_lower{kl},
+        m_upper{ku},
+        m_band(sz * (kl + ku + 1), T{}) {}
+
+  // Entries of dense outside the band are ignored
+  static band_matrix from_dense(const shell_matrix<T>& dense, std::size_t kl,
+                                std::size_t ku) {
+    if (!dense.square())
+      throw std::runtime_error("Unsuitable matrix sizes");
+    band_matrix ret{dense.nrows(), kl, ku};
+    for (std::size_t i = 0; i != ret.m_size; ++i)
+      for (std::size_t j = ret.col_begin(i); j != ret.col_end(i); ++j)
+        ret.m_band[ret.offset(i, j)] = dense[i][j];
+    return ret;
+  }
+
+  shell_matrix<T> to_dense() const {
+    shell_matrix<T> ret{m_size, m_size};
+    for (std::size_t i = 0; i != m_size; ++i)
+      for (std::size_t j = col_begin(i); j != col_end(i); ++j)
+        ret[i][j] = m_band[offset(i, j)];
+    return ret;
+  }
+
+  bool in_band(std::size_t i, std::size_t j) const {
+    return j + m_lower >= i && j <= i + m_upper;
+  }
+
+  // Columns of row i that lie inside both the band and the matrix
+  std::size_t col_begin(std::size_t i) const {
+    return i > m_lower ? i - m_lower : 0;
+  }
+  std::size_t col_end(std::size_t i) const {
+    return std::min(m_size, i + m_upper + 1);
+  }
+
+  T operator()(std::size_t i, std::size_t j) const {
+    return in_band(i, j) ? m_band[offset(i, j)] : T{};
+  }
+
+  T& at(std::size_t i, std::size_t j) {
+    if (i >= m_size || j >= m_size || !in_band(i, j))
+      throw std::out_of_range("Element outside the band");
+    return m_band[offset(i, j)];
+  }
+
+  // y = A * x in O(n * (kl + ku))
+  containers::vector<T> multiply(const containers::vector<T>& x) const {
+    if (x.size() != m_size)
+      throw std::runtime_error("Unsuitable matrix sizes");
+    containers::vector<T> ret(m_size);
+    kernels::detail::split_rows(
+        m_size, width(), [&](std::size_t row_frst, std::size_t row_lst) {
+          for (std::size_t i = row_frst; i != row_lst; ++i) {
+            compute_t<T> acc{};
+            for (std::size_t j = col_begin(i); j != col_end(i); ++j)
+              acc += m_band[offset(i, j)] * x[j];
+            ret[i] = static_cast<T>(acc);
+          }
+        });
+    return ret;
+  }
+
+  // A * B for a dense B in O(n * (kl + ku) * m)
+  shell_matrix<T> multiply(const shell_matrix<T>& rhs) const {
+    if (rhs.nrows() != m_size)
+      throw std::runtime_error("Unsuitable matrix sizes");
+    const std::size_t m = rhs.ncols();
+    shell_matrix<T> ret{m_size, m};
+    const T* b = rhs.data();
+    T* c = ret.data();
+    kernels::detail::split_rows(
+        m_size, width() * m, [&](std::size_t row_frst, std::size_t row_lst) {
+          for (std::size_t i = row_frst; i != row_lst; ++i)
+            for (std::size_t j = col_begin(i); j != col_end(i); ++j) {
+              const T r = m_band[offset(i, j)];
+              for (std::size_t p = 0; p != m; ++p)
+                c[i * m + p] += r * b[j * m + p];
+            }
+        });
+    return ret;
+  }
+
+  containers::vector<T> solve(const containers::vector<T>& rhs) const
+      requires std::is_floating_point_v<T>;
+
+  T determinant() const requires std::is_floating_point_v<T>;
+
+  std::size_t nrows() const { return m_size; }
+  std::size_t ncols() const { return m_size; }
+  std::size_t lower() const { return m_lower; }
+  std::size_t upper() const { return m_upper; }
+};
+
+// Banded LU with partial pivoting (as LAPACK gbtrf). Row swaps widen the
+// upper bandwidth of U to kl + ku, so the factor keeps 2 * kl + ku + 1
+// entries per row. Factor once, then solve any number of right-hand sides
+// in O(n * (kl + ku)) each.
+template <typename T>
+  requires std::is_floating_point_v<T>
+class band_lu final {
+  std::size_t m_size = 0;
+  std::size_t m_lower = 0;
+  std::size_t m_upper = 0;  // of U, including the fill-in
+
+  containers::vector<T> m_lu;
+  containers::vector<std::size_t> m_pivots;
+  int m_sign = 1;
+  bool m_singular = false;
+
+  std::size_t width() const { return m_lower + m_upper + 1; }
+  T& elem(std::size_t i, std::size_t j) {
+    return m_lu[i * width() + (j + m_lower - i)];
+  }
+  const T& elem(std::size_t i, std::size_t j) const {
+    return m_lu[i * width() + (j + m_lower - i)];
+  }
+
+ public:
+  explicit band_lu(const band_matrix<T>& band)
+      : m_size{band.nrows()},
+        m_lower{band.lower()},
+        m_upper{band.lower() + band.upper()},
+        m_lu(band.nrows() * (2 * band.lower() + band.upper() + 1), T{}),
+        m_pivots(band.nrows(), 0) {
+    for (std::size_t i = 0; i != m_size; ++i)
+      for (std::size_t j = band.col_begin(i); j != band.col_end(i); ++j)
+        elem(i, j) = band(i, j);
+
+    for (std::size_t k = 0; k != m_size; ++k) {
+      const std::size_t row_lst = std::min(m_size, k + m_lower + 1);
+      const std::size_t col_lst = std::min(m_size, k + m_upper + 1);
+
+      std::size_t piv = k;
+      for (std::size_t i = k + 1; i < row_lst; ++i)
+        if (std::abs(elem(i, k)) > std::abs(elem(piv, k)))
+          piv = i;
+      m_pivots[k] = piv;
+      if (elem(piv, k) == T{}) {
+        m_singular = true;
+        continue;
+      }
+      if (piv != k) {
+        for (std::size_t j = k; j != col_lst; ++j)
+          std::swap(elem(k, j), elem(piv, j));
+        m_sign = -m_sign;
+      }
+
+      const T pivot = elem(k, k);
+      for (std::size_t i = k + 1; i < row_lst; ++i) {
+        const T coef = elem(i, k) / pivot;
+        elem(i, k) = coef;
+        if (coef == T{})
+          continue;
+        for (std::size_t j = k + 1; j != col_lst; ++j)
+          elem(i, j) -= coef * elem(k, j);
+      }
+    }
+  }
+
+  bool singular() const { return m_singular; }
+
+  T determinant() const {
+    if (m_singular)
+      return T{};
+    T det = static_cast<T>(m_sign);
+    for (std::size_t k = 0; k != m_size; ++k)
+      det *= elem(k, k);
+    return det;
+  }
+
+  containers::vector<T> solve(const containers::vector<T>& rhs) const {
+    if (rhs.size() != m_size)
+      throw std::runtime_error("Unsuitable matrix sizes");
+    if (m_singular)
+      throw std::runtime_error("Singular matrix");
+
+    containers::vector<T> x{rhs};
+    for (std::size_t k = 0; k != m_size; ++k) {
+      std::swap(x[k], x[m_pivots[k]]);
+      const std::size_t row_lst = std::min(m_size, k + m_lower + 1);
+      for (std::size_t i = k + 1; i < row_lst; ++i)
+        x[i] -= elem(i, k) * x[k];
+    }
+    for (std::size_t i = m_size; i-- != 0;) {
+      const std::size_t col_lst = std::min(m_size, i + m_upper + 1);
+      T acc = x[i];
+      for (std::size_t j = i + 1; j < col_lst; ++j)
+        acc -= elem(i, j) * x[j];
+      x[i] = acc / elem(i, i);
+    }
+    return x;
+  }
+};
+
+template <typename T>
+containers::vector<T> band_matrix<T>::solve(
+    const containers::vector<T>& rhs) const
+    requires std::is_floating_point_v<T> {
+  return band_lu<T>{*this}.solve(rhs);
+}
+
+template <typename T>
+T band_matrix<T>::determinant() const requires std::is_floating_point_v<T> {
+  return band_lu<T>{*this}.determinant();
+}
+
+// n x n matrix with sub-, main and superdiagonal stored as three vectors
+template <typename T>
+class tridiagonal_matrix final {
+  containers::vector<T> m_lower;  // (i + 1, i)
+  containers::vector<T> m_diag;   // (i, i)
+  containers::vector<T> m_upper;  // (i, i + 1)
+
+ public:
+  explicit tridiagonal_matrix(std::size_t sz)
+      : m_lower(sz ? sz - 1 : 0, T{}),
+        m_diag(sz, T{}),
+        m_upper(sz ? sz - 1 : 0, T{}) {}
+
+  // Constant diagonals, e.g. (-1, 2, -1) for the 1D Laplacian
+  tridiagonal_matrix(std::size_t sz, T lower, T diag, T upper)
+      : m_lower(sz ? sz - 1 : 0, lower),
+        m_diag(sz, diag),
+        m_upper(sz ? sz - 1 : 0, upper) {}
+
+  // Entries of dense off the three diagonals are ignored
+  static tridiagonal_matrix from_dense(const shell_matrix<T>& dense) {
+    if (!dense.square())
+      throw std::runtime_error("Unsuitable matrix sizes");
+    tridiagonal_matrix ret{dense.nrows()};
+    for (std::size_t i = 0; i != ret.nrows(); ++i) {
+      ret.m_diag[i] = dense[i][i];
+      if (i + 1 != ret.nrows()) {
+        ret.m_lower[i] = dense[i + 1][i];
+        ret.m_upper[i] = dense[i][i + 1];
+      }
+    }
+    return ret;
+  }
+
+  shell_matrix<T> to_dense() const {
+    shell_matrix<T> ret{nrows(), nrows()};
+    for (std::size_t i = 0; i != nrows(); ++i) {
+      ret[i][i] = m_diag[i];
+      if (i + 1 != nrows()) {
+        ret[i + 1][i] = m_lower[i];
+        ret[i][i + 1] = m_upper[i];
+      }
+    }
+    return ret;
+  }
+
+  band_matrix<T> to_band() const {
+    band_matrix<T> ret{nrows(), 1, 1};
+    for (std::size_t i = 0; i != nrows(); ++i) {
+      ret.at(i, i) = m_diag[i];
+      if (i + 1 != nrows()) {
+        ret.at(i + 1, i) = m_lower[i];
+        ret.at(i, i + 1) = m_upper[i];
+      }
+    }
+    return ret;
+  }
+
+  T operator()(std::size_t i, std::size_t j) const {
+    if (i == j)
+      return m_diag[i];
+    if (i == j + 1)
+      return m_lower[j];
+    if (j == i + 1)
+      return m_upper[i];
+    return T{};
+  }
+
+  T& at(std::size_t i, std::size_t j) {
+    if (i >= nrows() || j >= nrows())
+      throw std::out_of_range("Element outside the matrix");
+    if (i == j)
+      return m_diag[i];
+    if (i == j + 1)
+      return m_lower[j];
+    if (j == i + 1)
+      return m_upper[i];
+    throw std::out_of_range("Element outside the band");
+  }
+
+  containers::vector<T>& lower() { return m_lower; }
+  containers::vector<T>& diag() { return m_diag; }
+  containers::vector<T>& upper() { return m_upper; }
+  const containers::vector<T>& lower() const { return m_lower; }
+  const containers::vector<T>& diag() const { return m_diag; }
+  const containers::vector<T>& upper() const { return m_upper; }
+
+  containers::vector<T> multiply(const containers::vector<T>& x) const {
+    const std::size_t n = nrows();
+    if (x.size() != n)
+      throw std::runtime_error("Unsuitable matrix sizes");
+    containers::vector<T> ret(n);
+    for (std::size_t i = 0; i != n; ++i) {
+      compute_t<T> acc = m_diag[i] * x[i];
+      if (i != 0)
+        acc += m_lower[i - 1] * x[i - 1];
+      if (i + 1 != n)
+        acc += m_upper[i] * x[i + 1];
+      ret[i] = static_cast<T>(acc);
+    }
+    return ret;
+  }
+
+  // Thomas algorithm, O(n) without pivoting. Stable for diagonally dominant
+  // or symmetric positive definite systems; use to_band().solve() otherwise.
+  containers::vector<T> solve(const containers::vector<T>& rhs) const
+      requires std::is_floating_point_v<T> {
+    const std::size_t n = nrows();
+    if (rhs.size() != n)
+      throw std::runtime_error("Unsuitable matrix sizes");
+    if (n == 0)
+      return containers::vector<T>{};
+
+    containers::vector<T> c_prime(n, T{});
+    containers::vector<T> x{rhs};
+    T denom = m_diag[0];
+    for (std::size_t i = 0;; ++i) {
+      if (denom == T{})
+        throw std::runtime_error("Zero pivot in tridiagonal solve");
+      x[i] /= denom;
+      if (i + 1 == n)
+        break;
+      c_prime[i] = m_upper[i] / denom;
+      denom = m_diag[i + 1] - m_lower[i] * c_prime[i];
+      x[i + 1] -= m_lower[i] * x[i];
+    }
+    for (std::size_t i = n - 1; i-- != 0;)
+      x[i] -= c_prime[i] * x[i + 1];
+    return x;
+  }
+
+  // Continuant recurrence, exact for integer types
+  T determinant() const {
+    T prev{1};
+    T cur = nrows() ? m_diag[0] : T{1};
+    for (std::size_t i = 1; i < nrows(); ++i) {
+      T next = m_diag[i] * cur - m_lower[i - 1] * m_upper[i - 1] * prev;
+      prev = cur;
+      cur = next;
+    }
+    return cur;
+  }
+
+  std::size_t nrows() const { return m_diag.size(); }
+  std::size_t ncols() const { return m_diag.size(); }
+};
+
+enum class triangle { lower, upper };
+
+// Lower or upper triangular n x n matrix packed row by row into
+// n * (n + 1) / 2 entries
+template <typename T>
+class triangular_matrix final {
+  std::size_t m_size = 0;
+  triangle m_kind = triangle::lower;
+
+  containers::vector<T> m_packed;
+
+  bool stored(std::size_t i, std::size_t j) const {
+    return m_kind == triangle::lower ? j <= i : j >= i;
+  }
+  std::size_t offset(std::size_t i, std::size_t j) const {
+    if (m_kind == triangle::lower)
+      return i * (i + 1) / 2 + j;
+    return i * m_size - i * (i - 1) / 2 + (j - i);
+  }
+  // Columns of row i inside the triangle
+  std::size_t col_begin(std::size_t i) const {
+    return m_kind == triangle::lower ? 0 : i;
+  }
+  std::size_t col_end(std::size_t i) const {
+    return m_kind == triangle::lower ? i + 1 : m_size;
+  }
+
+ public:
+  triangular_matrix(std::size_t sz, triangle kind)
+      : m_size{sz}, m_kind{kind}, m_packed(sz * (sz + 1) / 2, T{}) {}
+
+  // Entries of dense outside the triangle are ignored
+  static triangular_matrix from_dense(const shell_matrix<T>& dense,
+                                      triangle kind) {
+    if (!dense.square())
+      throw std::runtime_error("Unsuitable matrix sizes");
+    triangular_matrix ret{dense.nrows(), kind};
+    for (std::size_t i = 0; i != ret.m_size; ++i)
+      for (std::size_t j = ret.col_begin(i); j != ret.col_end(i); ++j)
+        ret.m_packed[ret.offset(i, j)] = dense[i][j];
+    return ret;
+  }
+
+  shell_matrix<T> to_dense() const {
+    shell_matrix<T> ret{m_size, m_size};
+    for (std::size_t i = 0; i != m_size; ++i)
+      for (std::size_t j = col_begin(i); j != col_end(i); ++j)
+        ret[i][j] = m_packed[offset(i, j)];
+    return ret;
+  }
+
+  T operator()(std::size_t i, std::size_t j) const {
+    return stored(i, j) ? m_packed[offset(i, j)] : T{};
+  }
+
+  T& at(std::size_t i, std::size_t j) {
+    if (i >= m_size || j >= m_size || !stored(i, j))
+      throw std::out_of_range("Element outside the triangle");
+    return m_packed[offset(i, j)];
+  }
+
+  containers::vector<T> multiply(const containers::vector<T>& x) const {
+    if (x.size() != m_size)
+      throw std::runtime_error("Unsuitable matrix sizes");
+    containers::vector<T> ret(m_size);
+    kernels::detail::split_rows(
+        m_size, m_size / 2 + 1, [&](std::size_t row_frst, std::size_t row_lst) {
+          for (std::size_t i = row_frst; i != row_lst; ++i) {
+            compute_t<T> acc{};
+            const T* row = m_packed.data() + offset(i, col_begin(i));
+            for (std::size_t j = col_begin(i); j != col_end(i); ++j)
+              acc += *row++ * x[j];
+            ret[i] = static_cast<T>(acc);
+          }
+        });
+    return ret;
+  }
+
+  shell_matrix<T> multiply(const shell_matrix<T>& rhs) const {
+    if (rhs.nrows() != m_size)
+      throw std::runtime_error("Unsuitable matrix sizes");
+    const std::size_t m = rhs.ncols();
+    shell_matrix<T> ret{m_size, m};
+    const T* b = rhs.data();
+    T* c = ret.data();
+    kernels::detail::split_rows(
+        m_size, (m_size / 2 + 1) * m,
+        [&](std::size_t row_frst, std::size_t row_lst) {
+          for (std::size_t i = row_frst; i != row_lst; ++i) {
+            const T* row = m_packed.data() + offset(i, col_begin(i));
+            for (std::size_t j = col_begin(i); j != col_end(i); ++j) {
+              const T r = *row++;
+              for (std::size_t p = 0; p != m; ++p)
+                c[i * m + p] += r * b[j * m + p];
+            }
+          }
+        });
+    return ret;
+  }
+
+  // Forward or back substitution, O(n^2) for the n^2 / 2 stored entries
+  containers::vector<T> solve(const containers::vector<T>& rhs) const
+      requires std::is_floating_point_v<T> {
+    if (rhs.size() != m_size)
+      throw std::runtime_error("Unsuitable matrix sizes");
+    containers::vector<T> x{rhs};
+    auto substitute = [&](std::size_t i) {
+      T acc = x[i];
+      for (std::size_t j = col_begin(i); j != col_end(i); ++j)
+        if (j != i)
+          acc -= m_packed[offset(i, j)] * x[j];
+      const T pivot = m_packed[offset(i, i)];
+      if (pivot == T{})
+        throw std::runtime_error("Singular matrix");
+      x[i] = acc / pivot;
+    };
+    if (m_kind == triangle::lower)
+      for (std::size_t i = 0; i != m_size; ++i)
+        substitute(i);
+    else
+      for (std::size_t i = m_size; i-- != 0;)
+        substitute(i);
+    return x;
+  }
+
+  T determinant() const {
+    T det{1};
+    for (std::size_t i = 0; i != m_size; ++i)
+      det *= m_packed[offset(i, i)];
+    return det;
+  }
+
+  triangle kind() const { return m_kind; }
+  std::size_t nrows() const { return m_size; }
+  std::size_t ncols() const { return m_size; }
+};
+
+}  // namespace linmath
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include "simd.hpp"
+
+namespace linmath {
+
+namespace kernels {
+
+// Host-dependent kernel parameters. The defaults suit common x86 cache
+// sizes; autotune.hpp measures better ones and tuning_cache.hpp stores them
+// per CPU model.
+struct tuning {
+  // Products smaller than this many multiply-adds stay on the calling thread
+  std::size_t gemm_parallel_threshold = std::size_t{1} << 16;
+  // Inner dimension is processed in panels of this size to keep B rows in
+  // cache
+  std::size_t gemm_block = 128;
+  // Transposes move square tiles of this size
+  std::size_t transpose_block = 32;
+  // Fills and copies of fewer elements stay on the calling thread
+  std::size_t fill_parallel_threshold = std::size_t{1} << 18;
+  // Elementwise maps of fewer elements stay on the calling thread
+  std::size_t map_parallel_threshold = std::size_t{1} << 15;
+  // Instruction set used by the quantized dot products
+  simd::isa quantized_isa = simd::best();
+};
+
+
+namespace detail {
+
+// Source of the starting parameters. tuning_cache.hpp points it at the
+// cache file reader, so the file I/O stays out of the kernel headers.
+inline tuning (*cached_tuning)() = nullptr;
+
+}  // namespace detail
+
+// Parameters every kernel reads. On first use they come from
+// detail::cached_tuning when a program includes tuning_cache.hpp (or
+// autotune.hpp), else the defaults. Change them only while no kernel runs.
+inline tuning& params() {
+  static tuning current = detail::cached_tuning ? detail::cached_tuning()
+                                                : tuning{};
+  return current;
+}
+
+}  // namespace kernels
+
+}  // namespace linmath
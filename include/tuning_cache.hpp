@@ -0,0 +1,206 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include "simd.hpp"
+#include "tuning.hpp"
+
+#ifdef LINMATH_X86_DISPATCH
+#include <cpuid.h>
+#endif
+
+namespace linmath {
+
+
+// Processor brand string, the key tuned parameters are stored under
+inline std::string cpu_model() {
+#ifdef LINMATH_X86_DISPATCH
+  unsigned regs[12] = {};
+  unsigned max_leaf = __get_cpuid_max(0x80000000u, nullptr);
+  if (max_leaf >= 0x80000004u) {
+    for (unsigned leaf = 0; leaf != 3; ++leaf)
+      __get_cpuid(0x80000002u + leaf, &regs[leaf * 4], &regs[leaf * 4 + 1],
+                  &regs[leaf * 4 + 2], &regs[leaf * 4 + 3]);
+    char brand[sizeof(regs) + 1] = {};
+    std::memcpy(brand, regs, sizeof(regs));
+    std::string ret{brand};
+    ret.erase(0, ret.find_first_not_of(' '));
+    ret.erase(ret.find_last_not_of(' ') + 1);
+    if (!ret.empty())
+      return ret;
+  }
+#endif
+  return "generic";
+}
+
+// $LINMATH_TUNING_FILE, else linmath/tuning under the user cache directory
+inline std::string tuning_path() {
+  if (const char* path = std::getenv("LINMATH_TUNING_FILE"))
+    return path;
+  if (const char* cache = std::getenv("XDG_CACHE_HOME"))
+    return std::string{cache} + "/linmath/tuning";
+  if (const char* home = std::getenv("HOME"))
+    return std::string{home} + "/.cache/linmath/tuning";
+  return "linmath_tuning";
+}
+
+namespace detail {
+
+using size_field = std::size_t kernels::tuning::*;
+
+inline const std::pair<const char*, size_field> tuning_fields[] = {
+    {"gemm_parallel_threshold", &kernels::tuning::gemm_parallel_threshold},
+    {"gemm_block", &kernels::tuning::gemm_block},
+    {"transpose_block", &kernels::tuning::transpose_block},
+    {"fill_parallel_threshold", &kernels::tuning::fill_parallel_threshold},
+    {"map_parallel_threshold", &kernels::tuning::map_parallel_threshold},
+};
+
+inline const char* isa_name(simd::isa level) {
+  switch (level) {
+    case simd::isa::scalar:
+      return "scalar";
+    case simd::isa::avx2:
+      return "avx2";
+    case simd::isa::avx512_vnni:
+      return "avx512_vnni";
+  }
+  return "scalar";
+}
+
+// The file holds one "[cpu model]" section per host type, each followed by
+// "name = value" lines. Returns every line outside the section for model
+// and, through entry, the lines inside it.
+inline std::vector<std::string> read_sections(const std::string& path,
+                                              const std::string& model,
+                                              std::vector<std::string>& entry) {
+  std::vector<std::string> others;
+  std::ifstream file{path};
+  std::string line;
+  bool inside = false;
+  while (std::getline(file, line)) {
+    if (!line.empty() && line.front() == '[' && line.back() == ']')
+      inside = line.substr(1, line.size() - 2) == model;
+    (inside ? entry : others).push_back(line);
+  }
+  return others;
+}
+
+inline bool parse_entry(const std::vector<std::string>& entry,
+                        kernels::tuning& out) {
+  bool found = false;
+  for (const std::string& line : entry) {
+    std::size_t eq = line.find('=');
+    if (eq == std::string::npos)
+      continue;
+    std::string name = line.substr(0, eq);
+    name.erase(name.find_last_not_of(' ') + 1);
+    std::istringstream value{line.substr(eq + 1)};
+
+    if (name == "quantized_isa") {
+      std::string level;
+      value >> level;
+      for (auto cand : {simd::isa::scalar, simd::isa::avx2,
+                        simd::isa::avx512_vnni})
+        if (level == isa_name(cand) && simd::supports(cand))
+          out.quantized_isa = cand;
+      continue;
+    }
+    for (auto [field_name, field] : tuning_fields) {
+      std::size_t parsed = 0;
+      if (name == field_name && (value >> parsed) && parsed > 0) {
+        out.*field = parsed;
+        found = true;
+      }
+    }
+  }
+  return found;
+}
+
+// Cached parameters for this CPU model on top of the defaults. Any failure
+// to read the file keeps the defaults; LINMATH_NO_TUNING skips the file.
+inline kernels::tuning startup_tuning() {
+  kernels::tuning ret{};
+  if (std::getenv("LINMATH_NO_TUNING"))
+    return ret;
+  try {
+    std::vector<std::string> entry;
+    read_sections(tuning_path(), cpu_model(), entry);
+    kernels::tuning loaded = ret;
+    if (parse_entry(entry, loaded))
+      ret = loaded;
+  } catch (...) {
+  }
+  return ret;
+}
+
+// Installs startup_tuning as the source kernels::params() starts from
+inline const bool cache_hooked =
+    (kernels::detail::cached_tuning = &startup_tuning, true);
+
+}  // namespace detail
+
+// Applies the parameters stored for this CPU model, returns false when the
+// file has none
+inline bool load_tuning(const std::string& path = tuning_path()) {
+  std::vector<std::string> entry;
+  detail::read_sections(path, cpu_model(), entry);
+  kernels::tuning loaded = kernels::params();
+  if (!detail::parse_entry(entry, loaded))
+    return false;
+  kernels::params() = loaded;
+  return true;
+}
+
+// Stores the current parameters under this CPU model, keeping the entries
+// of other models. The file is replaced atomically.
+inline void save_tuning(const std::string& path = tuning_path()) {
+  const std::string model = cpu_model();
+  std::vector<std::string> entry;
+  std::vector<std::string> others = detail::read_sections(path, model, entry);
+
+  std::filesystem::path parent = std::filesystem::path{path}.parent_path();
+  std::error_code ec;
+  if (!parent.empty())
+    std::filesystem::create_directories(parent, ec);
+
+  // a name of its own per writer, so concurrent tuning runs never rename
+  // each other's half-written files over the cache
+  const std::string tmp_path =
+      path + ".tmp." + std::to_string(std::random_device{}());
+  auto fail = [&tmp_path](const std::string& what) {
+    std::error_code ignored;
+    std::filesystem::remove(tmp_path, ignored);
+    throw std::runtime_error("Cannot write " + what);
+  };
+  {
+    std::ofstream file{tmp_path, std::ios::trunc};
+    if (!file)
+      throw std::runtime_error("Cannot open " + tmp_path);
+    for (const std::string& line : others)
+      file << line << '\n';
+    const kernels::tuning& current = kernels::params();
+    file << '[' << model << "]\n";
+    for (auto [name, field] : detail::tuning_fields)
+      file << name << " = " << current.*field << '\n';
+    file << "quantized_isa = " << detail::isa_name(current.quantized_isa)
+         << '\n';
+    file.close();
+    if (!file)
+      fail(tmp_path);
+  }
+  if (std::rename(tmp_path.c_str(), path.c_str()) != 0)
+    fail(path);
+}
+
+}  // namespace linmath
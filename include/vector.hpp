@@ -9,68 +9,176 @@
 #include <limits>
 #include <memory>
 #include <stdexcept>
+#include <type_traits>
+#include <utility>
 #include "iterator.hpp"
 
 namespace containers {
 static constexpr unsigned BOOST_ARCH_WORD_BITS = 32;
 
+// Tag for constructors that allocate storage without initializing it
+struct uninitialized_t {
+  explicit uninitialized_t() = default;
+};
+inline constexpr uninitialized_t uninitialized{};
+
+// Types whose objects can be moved to new storage with memcpy and the old
+// bytes simply dropped. Specialise for types that are not trivially
+// copyable but still relocate bitwise.
 template <typename T>
-class vector {
-  T* buf_begin_ptr = nullptr;
-  T* buf_end_ptr = nullptr;
-  T* buf_capacity_ptr = nullptr;
+struct is_trivially_relocatable : std::is_trivially_copyable<T> {};
 
+template <typename T>
+inline constexpr bool is_trivially_relocatable_v =
+    is_trivially_relocatable<T>::value;
+
+template <typename T>
+class vector {
   static constexpr std::size_t default_capacity = 8;
+  // Elements stored inside the object until the first heap allocation: as
+  // many as fit in 64 bytes, none for larger types
+  static constexpr std::size_t inline_capacity =
+      std::min<std::size_t>(default_capacity, 64 / sizeof(T));
+
+  template <std::size_t N>
+  struct inline_storage {
+    alignas(T) unsigned char bytes[N * sizeof(T)];
+  };
+  struct no_storage {};
+
+  [[no_unique_address]] std::conditional_t<(inline_capacity > 0),
+                                           inline_storage<inline_capacity>,
+                                           no_storage> inline_buf;
+
+  T* buf_begin_ptr = inline_data();
+  T* buf_end_ptr = buf_begin_ptr;
+  T* buf_capacity_ptr = buf_begin_ptr + inline_capacity;
+
+  const T* inline_data() const noexcept {
+    if constexpr (inline_capacity > 0)
+      return reinterpret_cast<const T*>(inline_buf.bytes);
+    else
+      return nullptr;
+  }
+  T* inline_data() noexcept {
+    return const_cast<T*>(std::as_const(*this).inline_data());
+  }
+  bool is_inline() const noexcept { return buf_begin_ptr == inline_data(); }
+
+  // Moves count elements from src into uninitialized dst and ends their
+  // lifetime in src. Types that may throw on move are copied instead so
+  // a failure leaves src intact.
+  static void relocate(T* src, std::size_t count, T* dst) {
+    if constexpr (is_trivially_relocatable_v<T>) {
+      if (count)
+        std::memcpy(static_cast<void*>(dst), src, count * sizeof(T));
+      return;
+    } else if constexpr (std::is_nothrow_move_constructible_v<T> ||
+                         !std::is_copy_constructible_v<T>) {
+      std::uninitialized_move_n(src, count, dst);
+    } else {
+      std::uninitialized_copy_n(src, count, dst);
+    }
+    std::destroy_n(src, count);
+  }
+
+  void release() noexcept {
+    std::destroy(buf_begin_ptr, buf_end_ptr);
+    if (!is_inline())
+      ::operator delete(buf_begin_ptr);
+    buf_begin_ptr = buf_end_ptr = inline_data();
+    buf_capacity_ptr = buf_begin_ptr + inline_capacity;
+  }
+
+  // Takes the elements of rhs, which is left empty; *this must be empty
+  // and inline
+  void steal(vector& rhs) noexcept(is_trivially_relocatable_v<T> ||
+                                   std::is_nothrow_move_constructible_v<T>) {
+    if (rhs.is_inline()) {
+      const std::size_t sz = rhs.size();
+      relocate(rhs.buf_begin_ptr, sz, buf_begin_ptr);
+      buf_end_ptr = buf_begin_ptr + sz;
+      rhs.buf_end_ptr = rhs.buf_begin_ptr;
+      return;
+    }
+    buf_begin_ptr = rhs.buf_begin_ptr;
+    buf_end_ptr = rhs.buf_end_ptr;
+    buf_capacity_ptr = rhs.buf_capacity_ptr;
+    rhs.buf_begin_ptr = rhs.buf_end_ptr = rhs.inline_data();
+    rhs.buf_capacity_ptr = rhs.buf_begin_ptr + inline_capacity;
+  }
+
+  // Moves the elements to a buffer of cap elements (inline if it fits)
+  void reallocate(std::size_t cap) {
+    const std::size_t sz = size();
+    const bool to_inline = cap <= inline_capacity;
+    if (to_inline && is_inline())
+      return;
+
+    T* new_buf = to_inline ? inline_data()
+                           : static_cast<T*>(::operator new(sizeof(T) * cap));
+    auto deleter = [to_inline](T* ptr) {
+      if (!to_inline)
+        ::operator delete(ptr);
+    };
+    std::unique_ptr<T, decltype(deleter)> raii_buf(new_buf, deleter);
+    relocate(buf_begin_ptr, sz, raii_buf.get());
+
+    if (!is_inline())
+      ::operator delete(buf_begin_ptr);
+    buf_begin_ptr = raii_buf.release();
+    buf_end_ptr = buf_begin_ptr + sz;
+    buf_capacity_ptr = buf_begin_ptr + (to_inline ? inline_capacity : cap);
+  }
 
  public:
   using it = iterator::myIterator<T>;
 
-  vector()
-      : buf_begin_ptr{static_cast<T*>(
-            ::operator new(sizeof(T) * default_capacity))},
-        buf_capacity_ptr{buf_begin_ptr + default_capacity},
-        buf_end_ptr{buf_begin_ptr} {}
+  // Never allocates; the first inline_capacity elements live in the object
+  vector() noexcept {}
 
   explicit vector(std::size_t count, T val = T{}) {
-    vector tmp{};
-    tmp.reserve(count);
-    tmp.fill_n(count, val);
-    *this = std::move(tmp);
+    reserve(count);
+    fill_n(count, val);
   }
 
-  ~vector() {
-    std::destroy(buf_begin_ptr, buf_end_ptr);
-    buf_end_ptr = buf_begin_ptr;
-    ::operator delete(buf_begin_ptr);
+  // count elements with indeterminate values, for buffers the caller
+  // overwrites anyway (and pages it wants to first-touch itself)
+  vector(std::size_t count, uninitialized_t)
+    requires std::is_trivially_copyable_v<T>
+  {
+    reserve(count);
+    buf_end_ptr = buf_begin_ptr + count;
   }
 
-  vector(vector&& rhs) noexcept {
-    std::swap(buf_begin_ptr, rhs.buf_begin_ptr);
-    std::swap(buf_end_ptr, rhs.buf_end_ptr);
-    std::swap(buf_capacity_ptr, rhs.buf_capacity_ptr);
+  ~vector() { release(); }
+
+  vector(vector&& rhs) noexcept(is_trivially_relocatable_v<T> ||
+                                std::is_nothrow_move_constructible_v<T>) {
+    steal(rhs);
   }
 
-  vector(vector& rhs) {
-    vector tmp{};
-    tmp.reserve(rhs.capacity());
+  vector(const vector& rhs) {
+    reserve(rhs.capacity());
 
     std::size_t sz = rhs.size();
-    if constexpr (std::is_trivially_copyable<T>::value)
-      std::memcpy(tmp.buf_begin_ptr, rhs.buf_begin_ptr, sz * sizeof(T));
-    else
+    if constexpr (std::is_trivially_copyable<T>::value) {
+      if (sz)
+        std::memcpy(buf_begin_ptr, rhs.buf_begin_ptr, sz * sizeof(T));
+    } else {
       std::uninitialized_copy(rhs.buf_begin_ptr, rhs.buf_end_ptr,
-                              tmp.buf_begin_ptr);
-    tmp.buf_end_ptr = tmp.buf_begin_ptr + sz;
-
-    *this = std::move(tmp);
+                              buf_begin_ptr);
+    }
+    buf_end_ptr = buf_begin_ptr + sz;
   }
 
-  vector& operator=(vector&& rhs) noexcept {
+  vector& operator=(vector&& rhs) noexcept(
+      is_trivially_relocatable_v<T> ||
+      std::is_nothrow_move_constructible_v<T>) {
     if (this == std::addressof(rhs))
       return *this;
-    std::swap(buf_begin_ptr, rhs.buf_begin_ptr);
-    std::swap(buf_end_ptr, rhs.buf_end_ptr);
-    std::swap(buf_capacity_ptr, rhs.buf_capacity_ptr);
+    release();
+    steal(rhs);
     return *this;
   }
 
@@ -78,39 +186,32 @@ class vector {
     if (this == std::addressof(rhs))
       return *this;
     vector tmp{rhs};
-    std::swap(*this, tmp);
+    *this = std::move(tmp);
     return *this;
   }
 
   T& operator[](std::size_t i) { return *(buf_begin_ptr + i); }
   const T& operator[](std::size_t i) const { return *(buf_begin_ptr + i); }
 
+  // Replaces the contents with count copies of value, capacity must
+  // already suffice
   void fill_n(std::size_t count, const T& value) {
-    if (count <= 0)
-      return;
-    it frst = (*this).begin();
-    for (std::size_t i = 0; i < count; ++i)
-      *frst++ = value;
+    clear();
+    std::uninitialized_fill_n(buf_begin_ptr, count, value);
     buf_end_ptr = buf_begin_ptr + count;
   }
 
   void reserve(std::size_t cap) {
     if (cap <= capacity())
       return;
+    reallocate(cap);
+  }
 
-    T* tmp_buf = static_cast<T*>(::operator new(sizeof(T) * cap));
-    auto deleter = [](T* ptr) {
-      ::operator delete(ptr);
-    };
-    std::unique_ptr<T, decltype(deleter)> raii_buf(tmp_buf, deleter);
-
-    const std::size_t sz = size();
-    std::memcpy(raii_buf.get(), buf_begin_ptr, sz * sizeof(T));
-
-    ::operator delete(buf_begin_ptr);
-    buf_begin_ptr = raii_buf.release();
-    buf_end_ptr = buf_begin_ptr + sz;
-    buf_capacity_ptr = buf_begin_ptr + cap;
+  // Drops unused capacity, moving back inline when the elements fit
+  void shrink_to_fit() {
+    if (size() == capacity() || is_inline())
+      return;
+    reallocate(size());
   }
 
   void reserve_if_neccessary() {
@@ -119,20 +220,46 @@ class vector {
     reserve(amortized(capacity()));
   }
 
+  // Vectors without inline storage start from default_capacity
   std::size_t amortized(std::size_t sz) const {
+    if (sz == 0)
+      return default_capacity;
     return std::size_t{1} << (BOOST_ARCH_WORD_BITS - __builtin_clz(sz));
   }
 
-  void push_back(T&& value) {
-    reserve_if_neccessary();
-    new (buf_end_ptr++) T{std::move(value)};
-  }
+  // The new element is constructed before existing ones are relocated, so
+  // args may refer into the vector itself
+  template <typename... Args>
+  T& emplace_back(Args&&... args) {
+    if (buf_end_ptr != buf_capacity_ptr)
+      return *new (buf_end_ptr++) T(std::forward<Args>(args)...);
 
-  void push_back(const T& value) {
-    reserve_if_neccessary();
-    new (buf_end_ptr++) T{value};  // new gives a strict guarantee
+    const std::size_t sz = size();
+    const std::size_t cap = amortized(capacity());
+    T* new_buf = static_cast<T*>(::operator new(sizeof(T) * cap));
+    auto deleter = [](T* ptr) { ::operator delete(ptr); };
+    std::unique_ptr<T, decltype(deleter)> raii_buf(new_buf, deleter);
+
+    T* elem = new (new_buf + sz) T(std::forward<Args>(args)...);
+    try {
+      relocate(buf_begin_ptr, sz, new_buf);
+    } catch (...) {
+      std::destroy_at(elem);
+      throw;
+    }
+
+    if (!is_inline())
+      ::operator delete(buf_begin_ptr);
+    buf_begin_ptr = raii_buf.release();
+    buf_end_ptr = buf_begin_ptr + sz + 1;
+    buf_capacity_ptr = buf_begin_ptr + cap;
+    return *elem;
   }
 
+  void push_back(T&& value) { emplace_back(std::move(value)); }
+
+  void push_back(const T& value) { emplace_back(value); }
+
   void pop() noexcept { std::destroy_at(--buf_end_ptr); }
 
   T& front() { return *buf_begin_ptr; }
@@ -149,12 +276,12 @@ class vector {
   void dump(std::ostream& os) const {
     std::size_t sz = size();
     std::size_t cap = capacity();
-    os << "size = " << sz << std::endl;
-    os << "capacity = " << cap << std::endl;
+    os << "size = " << sz << '\n';
+    os << "capacity = " << cap << '\n';
     os << "| ";
     for (std::size_t i = 0; i < sz; ++i)
       os << (*this)[i] << " ";
-    os << "|" << std::endl;
+    os << "|\n";
   }
 
   std::size_t size() const noexcept { return buf_end_ptr - buf_begin_ptr; }
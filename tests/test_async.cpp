@@ -0,0 +1,110 @@
+#include <gtest/gtest.h>
+#include <cstdlib>
+#include <iostream>
+#include "async.hpp"
+#include "shell_matrix.hpp"
+
+using sh_matrix = typename linmath::shell_matrix<double>;
+
+static sh_matrix filled(std::size_t rows, std::size_t cols, double seed) {
+  sh_matrix ret{rows, cols};
+  for (std::size_t i = 0; i < rows; ++i)
+    for (std::size_t j = 0; j < cols; ++j)
+      ret[i][j] = seed + static_cast<double>((i * 7 + j * 3) % 11) / 4;
+  return ret;
+}
+
+TEST(test_async, test_ready_task) {
+  auto t = linmath::make_ready_task(sh_matrix::identity(3));
+  ASSERT_TRUE(t.valid());
+  EXPECT_TRUE(t.ready());
+  EXPECT_TRUE(t.get() == sh_matrix::identity(3));
+}
+
+TEST(test_async, test_multiply) {
+  sh_matrix a = filled(40, 30, 1);
+  sh_matrix b = filled(30, 20, -2);
+  auto t = linmath::async_multiply(a, b);
+  EXPECT_TRUE(t.get() == a * b);
+}
+
+TEST(test_async, test_chain) {
+  sh_matrix a = filled(16, 16, 0.5);
+  sh_matrix b = filled(16, 16, -1);
+  sh_matrix c = filled(16, 16, 2);
+
+  // (a * b) and (b * c) are independent, the sum waits for both
+  auto ab = linmath::async_multiply(a, b);
+  auto bc = linmath::async_multiply(b, c);
+  auto sum = linmath::async_add(ab, bc);
+  auto res = linmath::async_scale(linmath::async_subtract(sum, a), 0.5);
+
+  sh_matrix expected = (a * b + b * c - a) * 0.5;
+  EXPECT_TRUE(res.get() == expected);
+  EXPECT_TRUE(ab.ready());
+  EXPECT_TRUE(bc.ready());
+}
+
+TEST(test_async, test_then) {
+  auto t = linmath::make_ready_task(filled(5, 5, 1));
+  auto tr = t.then([](const sh_matrix& m) { return m.trace(); });
+  EXPECT_DOUBLE_EQ(tr.get(), t.get().trace());
+
+  auto many = linmath::async_invoke(
+      [](const sh_matrix& x, const sh_matrix& y, double s) {
+        return (x + y).trace() * s;
+      },
+      t, t, tr);
+  EXPECT_DOUBLE_EQ(many.get(), 2 * t.get().trace() * tr.get());
+}
+
+TEST(test_async, test_transpose) {
+  sh_matrix a = filled(3, 5, 2);
+  sh_matrix expected{5, 3};
+  for (std::size_t i = 0; i < 3; ++i)
+    for (std::size_t j = 0; j < 5; ++j)
+      expected[j][i] = a[i][j];
+
+  auto t = linmath::async_transpose(a);
+  sh_matrix res = t.get();
+  ASSERT_EQ(res.nrows(), 5);
+  ASSERT_EQ(res.ncols(), 3);
+  EXPECT_TRUE(res == expected);
+  EXPECT_TRUE(a == filled(3, 5, 2));
+
+  // transposing a pending product: (a * b)^T
+  sh_matrix b = filled(5, 4, -1);
+  sh_matrix ab = a * b;
+  sh_matrix ab_t{4, 3};
+  for (std::size_t i = 0; i < 3; ++i)
+    for (std::size_t j = 0; j < 4; ++j)
+      ab_t[j][i] = ab[i][j];
+  auto chained = linmath::async_transpose(linmath::async_multiply(a, b));
+  EXPECT_TRUE(chained.get() == ab_t);
+}
+
+TEST(test_async, test_error_propagation) {
+  auto bad = linmath::async_multiply(filled(2, 3, 0), filled(2, 3, 0));
+  auto dependent = linmath::async_add(bad, filled(2, 3, 0));
+  EXPECT_THROW(bad.get(), std::runtime_error);
+  EXPECT_THROW(dependent.get(), std::runtime_error);
+}
+
+TEST(test_async, test_wide_graph) {
+  sh_matrix base = filled(8, 8, 1);
+  std::vector<linmath::task<sh_matrix>> layer;
+  for (int i = 0; i < 32; ++i)
+    layer.push_back(linmath::async_scale(base, static_cast<double>(i)));
+  while (layer.size() > 1) {
+    std::vector<linmath::task<sh_matrix>> next;
+    for (std::size_t i = 0; i + 1 < layer.size(); i += 2)
+      next.push_back(linmath::async_add(layer[i], layer[i + 1]));
+    layer = std::move(next);
+  }
+  EXPECT_TRUE(layer.front().get() == base * 496.0);
+}
+
+int main(int argc, char* argv[]) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
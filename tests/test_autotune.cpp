@@ -0,0 +1,134 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "autotune.hpp"
+
+using sh_matrix = typename linmath::shell_matrix<float>;
+
+static std::string temp_path(const char* name) {
+  return ::testing::TempDir() + name;
+}
+
+TEST(test_autotune, test_cpu_model) {
+  ASSERT_FALSE(linmath::cpu_model().empty());
+}
+
+TEST(test_autotune, test_save_load) {
+  const std::string path = temp_path("linmath_tuning_save");
+  {
+    std::ofstream file{path};
+    file << "[Some Other CPU]\ngemm_block = 16\n";
+  }
+
+  const linmath::kernels::tuning defaults{};
+  linmath::kernels::params().gemm_block = 64;
+  linmath::kernels::params().transpose_block = 8;
+  linmath::save_tuning(path);
+  linmath::kernels::params() = defaults;
+
+  ASSERT_TRUE(linmath::load_tuning(path));
+  EXPECT_EQ(linmath::kernels::params().gemm_block, 64);
+  EXPECT_EQ(linmath::kernels::params().transpose_block, 8);
+  EXPECT_EQ(linmath::kernels::params().map_parallel_threshold,
+            defaults.map_parallel_threshold);
+
+  // saving again replaces this model's entry and keeps the others
+  linmath::kernels::params().gemm_block = 256;
+  linmath::save_tuning(path);
+  std::ifstream file{path};
+  std::stringstream text;
+  text << file.rdbuf();
+  EXPECT_NE(text.str().find("[Some Other CPU]\ngemm_block = 16\n"),
+            std::string::npos);
+  EXPECT_EQ(text.str().find("gemm_block = 64"), std::string::npos);
+
+  linmath::kernels::params() = defaults;
+  EXPECT_FALSE(linmath::load_tuning(temp_path("linmath_tuning_missing")));
+  EXPECT_EQ(linmath::kernels::params().gemm_block, defaults.gemm_block);
+  std::remove(path.c_str());
+}
+
+TEST(test_autotune, test_concurrent_save) {
+  // every writer renames its own temporary file, none is left behind
+  const std::filesystem::path dir = temp_path("linmath_tuning_dir");
+  std::filesystem::remove_all(dir);
+  const std::string path = (dir / "tuning").string();
+  std::vector<std::thread> writers;
+  for (int t = 0; t < 8; ++t)
+    writers.emplace_back([&path] {
+      for (int rep = 0; rep < 20; ++rep)
+        linmath::save_tuning(path);
+    });
+  for (std::thread& writer : writers)
+    writer.join();
+
+  const auto files = std::distance(std::filesystem::directory_iterator{dir},
+                                   std::filesystem::directory_iterator{});
+  EXPECT_EQ(files, 1);
+  EXPECT_TRUE(linmath::load_tuning(path));
+  std::filesystem::remove_all(dir);
+}
+
+TEST(test_autotune, test_startup_tuning) {
+  // what kernels::params() starts from on its first use
+  EXPECT_EQ(linmath::kernels::detail::cached_tuning,
+            &linmath::detail::startup_tuning);
+  const std::string path = temp_path("linmath_tuning_startup");
+  {
+    std::ofstream file{path};
+    file << '[' << linmath::cpu_model() << "]\ngemm_block = 48\n";
+  }
+  ::setenv("LINMATH_TUNING_FILE", path.c_str(), 1);
+  ::unsetenv("LINMATH_NO_TUNING");
+  EXPECT_EQ(linmath::detail::startup_tuning().gemm_block, 48);
+
+  ::setenv("LINMATH_NO_TUNING", "1", 1);
+  EXPECT_EQ(linmath::detail::startup_tuning().gemm_block,
+            linmath::kernels::tuning{}.gemm_block);
+  ::unsetenv("LINMATH_NO_TUNING");
+  std::remove(path.c_str());
+  EXPECT_EQ(linmath::detail::startup_tuning().gemm_block,
+            linmath::kernels::tuning{}.gemm_block);
+}
+
+TEST(test_autotune, test_tune) {
+  const linmath::kernels::tuning defaults{};
+  linmath::autotune_settings settings;
+  settings.size = 64;
+  settings.repeats = 1;
+  auto tuned = linmath::autotune(settings);
+
+  std::size_t block = tuned.gemm_block;
+  EXPECT_TRUE(block == 32 || block == 64 || block == 128 || block == 256 ||
+              block == 512);
+  EXPECT_TRUE(simd::supports(tuned.quantized_isa));
+
+  // kernels stay correct under whatever won
+  sh_matrix a{3, 2, {1, 2, 3, 4, 5, 6}};
+  sh_matrix b{2, 2, {1, 0, 0, 1}};
+  ASSERT_TRUE(a * b == a);
+  a.transpose();
+  ASSERT_TRUE(a == sh_matrix(2, 3, {1, 3, 5, 2, 4, 6}));
+
+  const std::string path = temp_path("linmath_tuning_ensure");
+  std::remove(path.c_str());
+  linmath::ensure_tuned(path, settings);
+  linmath::kernels::params() = defaults;
+  ASSERT_TRUE(linmath::load_tuning(path));
+  std::remove(path.c_str());
+  linmath::kernels::params() = defaults;
+}
+
+int main(int argc, char* argv[]) {
+  ::testing::InitGoogleTest(&argc, argv);
+  // never read or write the user's cache file
+  ::setenv("LINMATH_TUNING_FILE", temp_path("linmath_tuning").c_str(), 1);
+  return RUN_ALL_TESTS();
+}
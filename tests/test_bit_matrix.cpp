@@ -0,0 +1,111 @@
+#include <gtest/gtest.h>
+#include <cstdlib>
+#include <iostream>
+#include "bit_matrix.hpp"
+
+using linmath::bit_matrix;
+
+static bit_matrix random_bits(std::size_t rows, std::size_t cols,
+                              int percent, unsigned seed) {
+  std::srand(seed);
+  bit_matrix ret{rows, cols};
+  for (std::size_t i = 0; i < rows; ++i)
+    for (std::size_t j = 0; j < cols; ++j)
+      if (std::rand() % 100 < percent)
+        ret.set(i, j);
+  return ret;
+}
+
+// Entry-by-entry reference product
+static bit_matrix reference_multiply(const bit_matrix& a, const bit_matrix& b,
+                                     bool gf2) {
+  bit_matrix ret{a.nrows(), b.ncols()};
+  for (std::size_t i = 0; i < a.nrows(); ++i)
+    for (std::size_t j = 0; j < b.ncols(); ++j) {
+      bool acc = false;
+      for (std::size_t p = 0; p < a.ncols(); ++p) {
+        bool term = a.get(i, p) && b.get(p, j);
+        acc = gf2 ? (acc != term) : (acc || term);
+      }
+      ret.set(i, j, acc);
+    }
+  return ret;
+}
+
+TEST(test_bit_matrix, test_access) {
+  bit_matrix a{3, 130};
+  ASSERT_EQ(a.words_per_row(), 3);
+  a.set(1, 129);
+  a.set(2, 64);
+  a.flip(0, 0);
+  ASSERT_TRUE(a.get(1, 129));
+  ASSERT_FALSE(a.get(1, 128));
+  ASSERT_EQ(a.count(), 3);
+  a.set(2, 64, false);
+  ASSERT_EQ(a.count(), 2);
+
+  linmath::shell_matrix<int> dense{2, 3, {0, 5, 0, -1, 0, 0}};
+  bit_matrix b = bit_matrix::from_dense(dense);
+  ASSERT_TRUE(b.get(0, 1));
+  ASSERT_TRUE(b.get(1, 0));
+  ASSERT_TRUE(b.to_dense() == linmath::shell_matrix<int>(2, 3, {0, 1, 0, 1, 0, 0}));
+}
+
+TEST(test_bit_matrix, test_multiply) {
+  for (std::size_t n : {std::size_t{10}, std::size_t{150}}) {
+    bit_matrix a = random_bits(n, 77 + n, 10, 1);
+    bit_matrix b = random_bits(77 + n, 91, 10, 2);
+    ASSERT_TRUE(linmath::bool_multiply(a, b) == reference_multiply(a, b, false));
+    ASSERT_TRUE(linmath::gf2_multiply(a, b) == reference_multiply(a, b, true));
+  }
+  EXPECT_THROW(linmath::bool_multiply(bit_matrix{2, 3}, bit_matrix{2, 3}),
+               std::runtime_error);
+}
+
+TEST(test_bit_matrix, test_gf2_elimination) {
+  bit_matrix id = bit_matrix::identity(100);
+  ASSERT_EQ(id.rank_gf2(), 100);
+
+  // rows 0..49 random, rows 50..99 sums of two of them
+  bit_matrix a = random_bits(100, 120, 50, 3);
+  for (std::size_t i = 50; i < 100; ++i)
+    for (std::size_t j = 0; j < 120; ++j)
+      a.set(i, j, a.get(i - 50, j) != a.get((i * 7) % 50, j));
+  std::size_t rank = a.rank_gf2();
+  ASSERT_LE(rank, 50);
+  ASSERT_GE(rank, 45);
+
+  bit_matrix r{a};
+  ASSERT_EQ(r.eliminate_gf2(), rank);
+  for (std::size_t i = rank; i < 100; ++i)
+    for (std::size_t j = 0; j < 120; ++j)
+      ASSERT_FALSE(r.get(i, j));
+}
+
+TEST(test_bit_matrix, test_closure) {
+  // chain 0 -> 1 -> ... -> n-1 plus an isolated cycle n -> n+1 -> n
+  const std::size_t n = 100;
+  bit_matrix g{n + 2, n + 2};
+  for (std::size_t i = 0; i + 1 < n; ++i)
+    g.set(i, i + 1);
+  g.set(n, n + 1);
+  g.set(n + 1, n);
+
+  bit_matrix c = g.transitive_closure();
+  for (std::size_t i = 0; i < n; ++i)
+    for (std::size_t j = 0; j < n; ++j)
+      ASSERT_EQ(c.get(i, j), j > i);
+  ASSERT_TRUE(c.get(n, n));
+  ASSERT_TRUE(c.get(n + 1, n + 1));
+  ASSERT_FALSE(c.get(0, n));
+
+  // closure is a fixed point of squaring
+  bit_matrix sq = linmath::bool_multiply(c, c);
+  sq |= c;
+  ASSERT_TRUE(sq == c);
+}
+
+int main(int argc, char* argv[]) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,193 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <utility>
+#include "cow_vector.hpp"
+#include "shell_matrix.hpp"
+
+static std::atomic<std::size_t> n_allocations{0};
+
+__attribute__((noinline)) void* operator new(std::size_t sz) {
+  ++n_allocations;
+  if (void* ptr = std::malloc(sz ? sz : 1))
+    return ptr;
+  throw std::bad_alloc{};
+}
+
+// kept out of line so the compiler does not pair new-expressions with free
+__attribute__((noinline)) void operator delete(void* ptr) noexcept {
+  std::free(ptr);
+}
+__attribute__((noinline)) void operator delete(void* ptr,
+                                               std::size_t) noexcept {
+  std::free(ptr);
+}
+
+using cow_vector = typename containers::cow_vector<int>;
+using cow_matrix = typename linmath::cow_matrix<double>;
+using sh_matrix = typename linmath::shell_matrix<double>;
+
+TEST(test_cow_vector, test_share_and_detach) {
+  cow_vector a(10, 7);
+  cow_vector b{a};
+  EXPECT_EQ(a.use_count(), 2);
+  EXPECT_EQ(std::as_const(a).data(), std::as_const(b).data());
+
+  // reads never detach
+  EXPECT_EQ(std::as_const(b)[3], 7);
+  EXPECT_EQ(a.use_count(), 2);
+
+  b[3] = 1;
+  EXPECT_EQ(b.use_count(), 1);
+  EXPECT_NE(std::as_const(a).data(), std::as_const(b).data());
+  EXPECT_EQ(std::as_const(a)[3], 7);
+  EXPECT_EQ(std::as_const(b)[3], 1);
+
+  // the sole owner writes in place
+  const int* before = std::as_const(b).data();
+  b.data()[0] = 5;
+  EXPECT_EQ(std::as_const(b).data(), before);
+}
+
+TEST(test_cow_vector, test_assign_and_move) {
+  cow_vector a(4, 1);
+  cow_vector b(2, 2);
+  b = a;
+  EXPECT_EQ(a.use_count(), 2);
+  EXPECT_EQ(b.size(), 4);
+
+  cow_vector c{std::move(b)};
+  EXPECT_EQ(a.use_count(), 2);
+  EXPECT_EQ(c.use_count(), 2);
+  c = cow_vector(3, 9);
+  EXPECT_EQ(std::as_const(c)[2], 9);
+}
+
+TEST(test_cow_vector, test_matrix_detach) {
+  const cow_matrix a{2, 2, {1, 2, 3, 4}};
+  cow_matrix b = a;
+  EXPECT_EQ(a.data(), std::as_const(b).data());
+
+  EXPECT_EQ(std::as_const(b)[1][0], 3);
+  EXPECT_EQ(a.data(), std::as_const(b).data());
+
+  b[1][0] = 10;
+  EXPECT_NE(a.data(), std::as_const(b).data());
+  EXPECT_EQ(a[1][0], 3);
+  EXPECT_EQ(std::as_const(b)[1][0], 10);
+
+  cow_matrix c = a;
+  c *= 2.0;
+  EXPECT_TRUE(a == cow_matrix(2, 2, {1, 2, 3, 4}));
+  EXPECT_TRUE(c == cow_matrix(2, 2, {2, 4, 6, 8}));
+
+  cow_matrix d = a;
+  d.transpose();
+  EXPECT_TRUE(a == cow_matrix(2, 2, {1, 2, 3, 4}));
+  EXPECT_TRUE(a * a == cow_matrix(2, 2, {7, 10, 15, 22}));
+}
+
+TEST(test_cow_vector, test_compound_in_place) {
+  // a sole owner is updated in its own buffer, without allocating
+  cow_matrix a{2, 2, {1, 2, 3, 4}};
+  const cow_matrix b{2, 2, {1, 1, 1, 1}};
+  const double* buffer = std::as_const(a).data();
+  std::size_t before = n_allocations;
+  a += b;
+  a -= b;
+  a *= 4.0;
+  a /= 2.0;
+  EXPECT_EQ(n_allocations - before, 0);
+  EXPECT_EQ(std::as_const(a).data(), buffer);
+  EXPECT_TRUE(a == cow_matrix(2, 2, {2, 4, 6, 8}));
+
+  // a shared buffer is detached once, the other owner keeps its values
+  cow_matrix c = a;
+  c += a;
+  EXPECT_NE(std::as_const(c).data(), std::as_const(a).data());
+  EXPECT_TRUE(a == cow_matrix(2, 2, {2, 4, 6, 8}));
+  EXPECT_TRUE(c == cow_matrix(2, 2, {4, 8, 12, 16}));
+  c -= c;
+  EXPECT_TRUE(c == cow_matrix(2, 2));
+}
+
+TEST(test_cow_vector, test_moved_from) {
+  cow_matrix a{2, 2, {1, 2, 3, 4}};
+  cow_matrix b{std::move(a)};
+  EXPECT_EQ(a.nrows(), 0);
+  EXPECT_EQ(std::as_const(a).begin(), std::as_const(a).end());
+
+  // a moved-from matrix can be copied, read and assigned to again
+  cow_matrix c{a};
+  EXPECT_EQ(c.nrows(), 0);
+  EXPECT_TRUE(c == a);
+  EXPECT_EQ(a.begin(), a.end());
+  a = b;
+  EXPECT_EQ(std::as_const(a)[1][0], 3);
+
+  cow_vector v(3, 1);
+  cow_vector w{std::move(v)};
+  cow_vector x{v};
+  EXPECT_EQ(x.size(), 0);
+  EXPECT_EQ(std::as_const(v).data(), nullptr);
+  v = w;
+  EXPECT_EQ(std::as_const(v)[2], 1);
+}
+
+TEST(test_cow_vector, test_iterator_detach) {
+  const cow_vector a{cow_vector(5, 0)};
+  cow_vector b{a};
+  int val = 5;
+  for (auto it = b.begin(); it != b.end(); ++it)
+    *it = val--;
+  std::sort(b.begin(), b.end());
+  EXPECT_EQ(a[0], 0);
+  EXPECT_EQ(std::as_const(b)[0], 1);
+
+  // const iteration keeps sharing
+  cow_vector c{a};
+  int sum = 0;
+  for (auto it = std::as_const(c).begin(); it != std::as_const(c).end(); ++it)
+    sum += *it;
+  EXPECT_EQ(sum, 0);
+  EXPECT_EQ(a.use_count(), 2);
+}
+
+TEST(test_cow_vector, test_allocation_count) {
+  // fan a large matrix out read-only to several consumers
+  const std::size_t consumers = 16;
+  auto fan_out = [consumers](const auto& src) {
+    double sum = 0;
+    for (std::size_t i = 0; i < consumers; ++i) {
+      auto copy = src;
+      sum += std::as_const(copy).trace();
+    }
+    return sum;
+  };
+
+  const sh_matrix deep = sh_matrix::identity(256);
+  const cow_matrix shared = cow_matrix::identity(256);
+
+  std::size_t before = n_allocations;
+  double deep_sum = fan_out(deep);
+  std::size_t deep_allocs = n_allocations - before;
+
+  before = n_allocations;
+  double shared_sum = fan_out(shared);
+  std::size_t shared_allocs = n_allocations - before;
+
+  std::cout << "allocations for " << consumers
+            << " copies: deep = " << deep_allocs
+            << ", copy-on-write = " << shared_allocs << '\n';
+  EXPECT_EQ(deep_sum, shared_sum);
+  EXPECT_GE(deep_allocs, consumers);
+  EXPECT_EQ(shared_allocs, 0);
+}
+
+int main(int argc, char* argv[]) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
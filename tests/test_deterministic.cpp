@@ -0,0 +1,188 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "eigen.hpp"
+#include "half.hpp"
+#include "quantized.hpp"
+
+using sh_matrix = typename linmath::shell_matrix<double>;
+
+static const std::size_t thread_counts[] = {1, 2, 3, 4, 7};
+
+template <typename T>
+static linmath::shell_matrix<T> random_matrix(std::size_t rows,
+                                              std::size_t cols,
+                                              unsigned seed) {
+  std::srand(seed);
+  linmath::shell_matrix<T> ret{rows, cols};
+  for (std::size_t i = 0; i < rows; ++i)
+    for (std::size_t j = 0; j < cols; ++j)
+      ret[i][j] = static_cast<T>(static_cast<float>(std::rand()) / RAND_MAX -
+                                 0.5f);
+  return ret;
+}
+
+template <typename T>
+static bool same_bits(const linmath::shell_matrix<T>& lhs,
+                      const linmath::shell_matrix<T>& rhs) {
+  return lhs.nrows() == rhs.nrows() && lhs.ncols() == rhs.ncols() &&
+         std::memcmp(lhs.data(), rhs.data(),
+                     lhs.nrows() * lhs.ncols() * sizeof(T)) == 0;
+}
+
+template <typename T>
+static bool same_bits(const T& lhs, const T& rhs) {
+  return std::memcmp(&lhs, &rhs, sizeof(T)) == 0;
+}
+
+// Runs fn in deterministic mode on a fresh pool of every size in
+// thread_counts and checks each result against the single-thread one
+template <typename F>
+static void expect_reproducible(F fn) {
+  parallel::deterministic_scope mode;
+  auto run = [&fn](std::size_t threads) {
+    parallel::thread_pool pool{threads};
+    parallel::pool_scope scope{pool};
+    return fn();
+  };
+  auto ref = run(thread_counts[0]);
+  for (std::size_t threads : thread_counts)
+    EXPECT_TRUE(same_bits(run(threads), ref)) << threads << " threads";
+}
+
+TEST(test_deterministic, test_chunks) {
+  parallel::deterministic_scope mode;
+  std::vector<std::pair<std::size_t, std::size_t>> ref;
+  for (std::size_t threads : thread_counts) {
+    parallel::thread_pool pool{threads};
+    parallel::pool_scope scope{pool};
+    std::vector<std::pair<std::size_t, std::size_t>> chunks;
+    std::mutex mutex;
+    parallel::for_each_chunk(1000, 3, [&](std::size_t frst, std::size_t lst) {
+      std::lock_guard<std::mutex> lock{mutex};
+      chunks.emplace_back(frst, lst);
+    });
+    std::sort(chunks.begin(), chunks.end());
+    ASSERT_EQ(chunks.size(), parallel::deterministic_chunks);
+    ASSERT_EQ(chunks.front().first, 0);
+    ASSERT_EQ(chunks.back().second, 1000);
+    if (ref.empty())
+      ref = chunks;
+    ASSERT_TRUE(chunks == ref);
+  }
+}
+
+TEST(test_deterministic, test_chunk_placement) {
+  // every thread takes one contiguous run of chunks, as in the default mode
+  parallel::deterministic_scope mode;
+  parallel::thread_pool pool{3};
+  parallel::pool_scope scope{pool};
+  std::vector<std::pair<std::size_t, std::thread::id>> owners;
+  std::mutex mutex;
+  parallel::for_each_chunk(1000, 1, [&](std::size_t frst, std::size_t) {
+    std::lock_guard<std::mutex> lock{mutex};
+    owners.emplace_back(frst, std::this_thread::get_id());
+  });
+  std::sort(owners.begin(), owners.end());
+  ASSERT_EQ(owners.size(), parallel::deterministic_chunks);
+  std::size_t runs = 1;
+  for (std::size_t idx = 1; idx < owners.size(); ++idx)
+    runs += owners[idx].second != owners[idx - 1].second;
+  EXPECT_EQ(runs, pool.size());
+}
+
+TEST(test_deterministic, test_reductions) {
+  auto a = random_matrix<float>(300, 301, 5);
+  expect_reproducible([&] { return a.sum(); });
+  expect_reproducible([&] { return a.norm(); });
+
+  long double ref = 0;
+  for (std::size_t i = 0; i < a.nrows(); ++i)
+    for (std::size_t j = 0; j < a.ncols(); ++j)
+      ref += a[i][j];
+  parallel::deterministic_scope mode;
+  EXPECT_NEAR(a.sum(), static_cast<double>(ref), 1e-2);
+
+  auto h = random_matrix<linmath::half>(200, 100, 6);
+  expect_reproducible([&] { return h.sum(); });
+}
+
+TEST(test_deterministic, test_products) {
+  auto a = random_matrix<double>(200, 150, 1);
+  auto b = random_matrix<double>(150, 170, 2);
+  expect_reproducible([&] { return sh_matrix{a * b}; });
+  expect_reproducible([&] {
+    sh_matrix c{a};
+    return c.transform([](double x) { return x * x - 1; });
+  });
+
+  auto ha = random_matrix<linmath::half>(130, 120, 3);
+  auto hb = random_matrix<linmath::half>(120, 110, 4);
+  expect_reproducible(
+      [&] { return linmath::shell_matrix<linmath::half>{ha * hb}; });
+
+  auto s = random_matrix<double>(150, 150, 7);
+  sh_matrix st{s};
+  st.transpose();
+  sh_matrix sym = s + st;
+  expect_reproducible([&] {
+    return linmath::top_eigenpairs(sym, 3).vectors;
+  });
+}
+
+// Kernels dispatched on the instruction set must agree with the scalar path
+TEST(test_deterministic, test_dispatch) {
+  auto a = random_matrix<float>(70, 90, 8);
+  auto b = random_matrix<float>(90, 60, 9);
+  auto& params = linmath::kernels::params();
+  const simd::isa saved = params.quantized_isa;
+  params.quantized_isa = simd::isa::scalar;
+  auto ref = linmath::quantized_multiply<std::int8_t>(a, b);
+  for (auto level : {simd::isa::avx2, simd::isa::avx512_vnni}) {
+    if (!simd::supports(level))
+      continue;
+    params.quantized_isa = level;
+    EXPECT_TRUE(
+        same_bits(linmath::quantized_multiply<std::int8_t>(a, b), ref));
+  }
+  params.quantized_isa = saved;
+
+#ifdef LINMATH_X86_DISPATCH
+  if (!simd::has_f16c())
+    GTEST_SKIP() << "no F16C";
+  // every finite and infinite half, and floats around every half
+  std::vector<std::uint16_t> bits;
+  for (std::uint32_t u = 0; u != 0x10000; ++u)
+    if ((u & 0x7c00) != 0x7c00 || (u & 0x3ff) == 0)
+      bits.push_back(static_cast<std::uint16_t>(u));
+  std::vector<float> wide(bits.size());
+  linmath::kernels::detail::widen_f16c(bits.data(), wide.data(), bits.size());
+  for (std::size_t i = 0; i < bits.size(); ++i)
+    ASSERT_TRUE(
+        same_bits(wide[i], linmath::detail::half_bits_to_float(bits[i])))
+        << bits[i];
+
+  std::vector<float> probes;
+  for (float f : wide)
+    probes.insert(probes.end(), {f, std::nextafter(f, 0.0f),
+                                 std::nextafter(f, 1e9f), f * 1.0005f});
+  std::vector<std::uint16_t> narrow(probes.size());
+  linmath::kernels::detail::narrow_f16c(probes.data(), narrow.data(),
+                                        probes.size());
+  for (std::size_t i = 0; i < probes.size(); ++i)
+    ASSERT_EQ(narrow[i], linmath::detail::float_to_half_bits(probes[i]))
+        << probes[i];
+#endif
+}
+
+int main(int argc, char* argv[]) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,104 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include "eigen.hpp"
+
+using sh_matrix = typename linmath::shell_matrix<double>;
+
+static sh_matrix random_symmetric(std::size_t sz, unsigned seed) {
+  std::srand(seed);
+  sh_matrix ret{sz, sz};
+  for (std::size_t i = 0; i < sz; ++i)
+    for (std::size_t j = 0; j <= i; ++j)
+      ret[i][j] = ret[j][i] =
+          static_cast<double>(std::rand()) / RAND_MAX - 0.5;
+  return ret;
+}
+
+TEST(test_eigen, test_diag) {
+  std::vector<double> vals{1, -9, 3, 7, 2, 5, 0.5, 4, 8, 6, -1, 0.25};
+  sh_matrix a = sh_matrix::diag(vals.size(), vals.begin(), vals.end());
+
+  auto res = linmath::top_eigenpairs(a, 3);
+  ASSERT_TRUE(res.converged);
+  EXPECT_NEAR(res.values[0], -9, 1e-6);
+  EXPECT_NEAR(res.values[1], 8, 1e-6);
+  EXPECT_NEAR(res.values[2], 7, 1e-6);
+  EXPECT_NEAR(std::abs(res.vectors[1][0]), 1, 1e-6);
+  EXPECT_NEAR(std::abs(res.vectors[8][1]), 1, 1e-6);
+}
+
+TEST(test_eigen, test_residual) {
+  const std::size_t sz = 120;
+  const std::size_t k = 4;
+  sh_matrix a = random_symmetric(sz, 42);
+  linmath::eigen_settings<double> settings;
+  settings.tolerance = 1e-8;
+
+  auto res = linmath::top_eigenpairs(a, k, settings);
+  ASSERT_TRUE(res.converged);
+  ASSERT_EQ(res.vectors.nrows(), sz);
+  ASSERT_EQ(res.vectors.ncols(), k);
+
+  sh_matrix av = a * res.vectors;
+  for (std::size_t j = 0; j < k; ++j) {
+    double resid = 0, norm = 0;
+    for (std::size_t i = 0; i < sz; ++i) {
+      double diff = av[i][j] - res.values[j] * res.vectors[i][j];
+      resid += diff * diff;
+      norm += res.vectors[i][j] * res.vectors[i][j];
+    }
+    EXPECT_NEAR(norm, 1, 1e-10);
+    EXPECT_LE(std::sqrt(resid), 1e-6 * std::abs(res.values[j]));
+    if (j) {
+      EXPECT_GE(std::abs(res.values[j - 1]), std::abs(res.values[j]));
+    }
+  }
+}
+
+TEST(test_eigen, test_operator) {
+  // 1D Laplacian applied without storing the matrix
+  const std::size_t sz = 50;
+  auto apply = [sz](const sh_matrix& q) {
+    sh_matrix ret{q.nrows(), q.ncols()};
+    for (std::size_t i = 0; i < sz; ++i)
+      for (std::size_t j = 0; j < q.ncols(); ++j) {
+        double val = 2 * q[i][j];
+        if (i)
+          val -= q[i - 1][j];
+        if (i + 1 < sz)
+          val -= q[i + 1][j];
+        ret[i][j] = val;
+      }
+    return ret;
+  };
+
+  linmath::eigen_settings<double> settings;
+  settings.block_size = 24;
+  auto res = linmath::top_eigenpairs<double>(sz, apply, 2, settings);
+  ASSERT_TRUE(res.converged);
+  const double pi = std::acos(-1.0);
+  for (std::size_t j = 0; j < 2; ++j) {
+    double expected = 2 - 2 * std::cos((sz - j) * pi / (sz + 1));
+    EXPECT_NEAR(res.values[j], expected, 1e-6);
+  }
+}
+
+TEST(test_eigen, test_iteration_limit) {
+  sh_matrix a = random_symmetric(60, 7);
+  linmath::eigen_settings<double> settings;
+  settings.tolerance = 1e-14;
+  settings.max_iterations = 2;
+  settings.block_size = 3;
+
+  auto res = linmath::top_eigenpairs(a, 3, settings);
+  EXPECT_FALSE(res.converged);
+  EXPECT_EQ(res.iterations, 2);
+  EXPECT_THROW(linmath::top_eigenpairs(a, 61), std::invalid_argument);
+}
+
+int main(int argc, char* argv[]) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,148 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include "half.hpp"
+
+using linmath::bfloat16;
+using linmath::half;
+using h_matrix = typename linmath::shell_matrix<half>;
+using bf_matrix = typename linmath::shell_matrix<bfloat16>;
+using f_matrix = typename linmath::shell_matrix<float>;
+
+static f_matrix random_matrix(std::size_t rows, std::size_t cols,
+                              unsigned seed) {
+  std::srand(seed);
+  f_matrix ret{rows, cols};
+  for (std::size_t i = 0; i < rows; ++i)
+    for (std::size_t j = 0; j < cols; ++j)
+      ret[i][j] = static_cast<float>(std::rand()) / RAND_MAX * 2 - 1;
+  return ret;
+}
+
+template <typename H>
+static linmath::shell_matrix<H> narrow(const f_matrix& src) {
+  linmath::shell_matrix<H> ret{src.nrows(), src.ncols()};
+  for (std::size_t i = 0; i < src.nrows(); ++i)
+    for (std::size_t j = 0; j < src.ncols(); ++j)
+      ret[i][j] = src[i][j];
+  return ret;
+}
+
+template <typename H>
+static f_matrix widen(const linmath::shell_matrix<H>& src) {
+  f_matrix ret{src.nrows(), src.ncols()};
+  for (std::size_t i = 0; i < src.nrows(); ++i)
+    for (std::size_t j = 0; j < src.ncols(); ++j)
+      ret[i][j] = src[i][j];
+  return ret;
+}
+
+TEST(test_half, test_conversion) {
+  EXPECT_EQ(half(1.0f).bits(), 0x3c00);
+  EXPECT_EQ(half(-2.0f).bits(), 0xc000);
+  EXPECT_EQ(half(65504.0f).bits(), 0x7bff);
+  EXPECT_EQ(half(65520.0f).bits(), 0x7c00);
+  EXPECT_EQ(half(std::ldexp(1.0f, -24)).bits(), 0x0001);
+  // ties round to even
+  EXPECT_EQ(half(1.0f + std::ldexp(1.0f, -11)).bits(), 0x3c00);
+  EXPECT_EQ(half(1.0f + 3 * std::ldexp(1.0f, -11)).bits(), 0x3c02);
+  EXPECT_TRUE(std::isnan(float(half(std::nanf("")))));
+  EXPECT_EQ(float(half::from_bits(0x0001)), std::ldexp(1.0f, -24));
+  EXPECT_EQ(float(half::from_bits(0xfc00)),
+            -std::numeric_limits<float>::infinity());
+
+  EXPECT_EQ(bfloat16(1.0f).bits(), 0x3f80);
+  EXPECT_EQ(float(bfloat16(3.140625f)), 3.140625f);
+  EXPECT_TRUE(std::isnan(float(bfloat16(std::nanf("")))));
+}
+
+TEST(test_half, test_bulk_conversion) {
+  // all finite halves survive a round trip through the bulk converters
+  std::vector<half> src;
+  for (std::uint32_t bits = 0; bits < 0x10000; ++bits)
+    if ((bits & 0x7c00) != 0x7c00)
+      src.push_back(half::from_bits(static_cast<std::uint16_t>(bits)));
+
+  std::vector<float> wide(src.size());
+  std::vector<half> back(src.size());
+  linmath::compute_type<half>::widen(src.data(), wide.data(), src.size());
+  linmath::compute_type<half>::narrow(wide.data(), back.data(), src.size());
+  for (std::size_t i = 0; i < src.size(); ++i) {
+    ASSERT_EQ(wide[i], float(src[i]));
+    ASSERT_EQ(back[i].bits(), src[i].bits());
+  }
+
+  std::vector<float> vals{0.1f, -3.3f, 1e-6f, 7e4f, 2.5e-5f, 1000.7f, 0.3f,
+                          -0.7f, 12.01f};
+  std::vector<half> narrowed(vals.size());
+  linmath::compute_type<half>::narrow(vals.data(), narrowed.data(),
+                                      vals.size());
+  for (std::size_t i = 0; i < vals.size(); ++i)
+    EXPECT_EQ(narrowed[i].bits(), half(vals[i]).bits());
+}
+
+TEST(test_half, test_arithmetic) {
+  f_matrix a = random_matrix(9, 13, 1);
+  f_matrix b = random_matrix(9, 13, 2);
+  h_matrix ha = narrow<half>(a);
+  h_matrix hb = narrow<half>(b);
+  EXPECT_TRUE(widen(ha + hb) == widen(narrow<half>(widen(ha) + widen(hb))));
+  EXPECT_TRUE(widen(ha - hb) == widen(narrow<half>(widen(ha) - widen(hb))));
+  EXPECT_TRUE(ha * half(2.0f) == ha + ha);
+  EXPECT_TRUE((ha / half(4.0f)) * half(4.0f) == ha);
+
+  bf_matrix ba = narrow<bfloat16>(a);
+  bf_matrix bb = narrow<bfloat16>(b);
+  EXPECT_TRUE(ba + bb == narrow<bfloat16>(a + b));
+}
+
+TEST(test_half, test_multiplication) {
+  // several row tiles and k-panels
+  const std::size_t n = 131, k = 300, m = 17;
+  f_matrix a = random_matrix(n, k, 3);
+  f_matrix b = random_matrix(k, m, 4);
+  h_matrix ha = narrow<half>(a);
+  h_matrix hb = narrow<half>(b);
+  bf_matrix ba = narrow<bfloat16>(a);
+  bf_matrix bb = narrow<bfloat16>(b);
+
+  // reference on the rounded inputs, so only the output rounding remains
+  f_matrix ref_h = widen(ha) * widen(hb);
+  f_matrix ref_bf = widen(ba) * widen(bb);
+  f_matrix res_h = widen(ha * hb);
+  f_matrix res_bf = widen(ba * bb);
+  for (std::size_t i = 0; i < n; ++i)
+    for (std::size_t j = 0; j < m; ++j) {
+      EXPECT_NEAR(res_h[i][j], ref_h[i][j],
+                  std::abs(ref_h[i][j]) * 1e-3f + 1e-4f);
+      EXPECT_NEAR(res_bf[i][j], ref_bf[i][j],
+                  std::abs(ref_bf[i][j]) * 8e-3f + 1e-4f);
+    }
+}
+
+TEST(test_half, test_trace) {
+  // accumulating in half would stall at 2048
+  const h_matrix a = h_matrix::identity(3000);
+  EXPECT_EQ(float(a.trace()), 3000.0f);
+}
+
+TEST(test_half, test_transform) {
+  h_matrix a{2, 2, {0.5f, -1.5f, 2.0f, -4.0f}};
+  h_matrix b{2, 2, {1.0f, 1.0f, 1.0f, 1.0f}};
+  // the lambda sees floats, so the fused result is rounded only once
+  h_matrix c =
+      a.zip_with([](float x, float y) { return x * x + y; }, b);
+  EXPECT_EQ(float(c[0][0]), 1.25f);
+  EXPECT_EQ(float(c[1][1]), 17.0f);
+  a.apply_inplace([](float x) { return x < 0 ? 0.0f : x; });
+  EXPECT_EQ(float(a[0][1]), 0.0f);
+  EXPECT_EQ(float(a[1][0]), 2.0f);
+}
+
+int main(int argc, char* argv[]) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include "io.hpp"
+
+using sh_matrix = typename linmath::shell_matrix<double>;
+
+static sh_matrix random_matrix(std::size_t rows, std::size_t cols,
+                               unsigned seed) {
+  std::srand(seed);
+  sh_matrix ret{rows, cols};
+  for (std::size_t i = 0; i < rows; ++i)
+    for (std::size_t j = 0; j < cols; ++j)
+      ret[i][j] = (static_cast<double>(std::rand()) / RAND_MAX - 0.5) *
+                  std::pow(10.0, std::rand() % 20 - 10);
+  return ret;
+}
+
+static bool bitwise_equal(const sh_matrix& lhs, const sh_matrix& rhs) {
+  if (lhs.nrows() != rhs.nrows() || lhs.ncols() != rhs.ncols())
+    return false;
+  return std::equal(lhs.data(), lhs.data() + lhs.nrows() * lhs.ncols(),
+                    rhs.data());
+}
+
+TEST(test_io, test_parse) {
+  std::string text = "1 2.5 -3\r\n\n  4,\t5e2;+6\n7 8 9";
+  auto matr = linmath::parse_text<double>(text);
+  EXPECT_TRUE(matr == sh_matrix(3, 3, {1, 2.5, -3, 4, 500, 6, 7, 8, 9}));
+
+  auto ints = linmath::parse_text<int>("1 2\n3 4\n");
+  EXPECT_TRUE(ints == linmath::shell_matrix<int>(2, 2, {1, 2, 3, 4}));
+
+  auto empty = linmath::parse_text<float>("\n\n");
+  EXPECT_EQ(empty.nrows(), 0);
+}
+
+TEST(test_io, test_malformed) {
+  EXPECT_THROW(linmath::parse_text<double>("1 2\n3\n"), std::runtime_error);
+  EXPECT_THROW(linmath::parse_text<double>("1 2\n3 4 5\n"),
+               std::runtime_error);
+  EXPECT_THROW(linmath::parse_text<double>("1 x\n"), std::runtime_error);
+  EXPECT_THROW(linmath::parse_text<int>("1 2.5\n"), std::runtime_error);
+}
+
+TEST(test_io, test_empty_fields) {
+  // every , or ; delimits exactly one field
+  EXPECT_THROW(linmath::parse_text<double>("1,,2\n"), std::runtime_error);
+  EXPECT_THROW(linmath::parse_text<double>("1, ;2\n"), std::runtime_error);
+  EXPECT_THROW(linmath::parse_text<double>("1,2\n,3\n"), std::runtime_error);
+  EXPECT_THROW(linmath::parse_text<double>("1,2\n3,4,\n"),
+               std::runtime_error);
+  EXPECT_THROW(linmath::parse_text<double>("1 2\n3 ,, 4\n"),
+               std::runtime_error);
+  auto matr = linmath::parse_text<double>("1 , 2;3\n4,5 ; 6\n");
+  EXPECT_TRUE(matr == sh_matrix(2, 3, {1, 2, 3, 4, 5, 6}));
+}
+
+TEST(test_io, test_roundtrip) {
+  for (char delim : {' ', ','}) {
+    sh_matrix matr = random_matrix(37, 11, 1);
+    std::ostringstream os;
+    linmath::write_text(os, matr, delim);
+    std::istringstream is{os.str()};
+    EXPECT_TRUE(bitwise_equal(linmath::read_text<double>(is), matr));
+  }
+
+  // a stream that cannot seek is read through its buffer
+  struct forward_only : std::stringbuf {
+    using std::stringbuf::stringbuf;
+    pos_type seekoff(off_type, std::ios::seekdir,
+                     std::ios::openmode) override {
+      return pos_type(off_type(-1));
+    }
+  };
+  forward_only buf{"1 2\n3 4\n"};
+  std::istream is{&buf};
+  EXPECT_TRUE(linmath::read_text<double>(is) == sh_matrix(2, 2, {1, 2, 3, 4}));
+}
+
+TEST(test_io, test_large_roundtrip) {
+  // large enough to take the parallel paths in both directions
+  sh_matrix matr = random_matrix(700, 130, 2);
+  std::ostringstream os;
+  linmath::write_text(os, matr);
+  ASSERT_GT(os.str().size(), std::size_t{1} << 16);
+  EXPECT_TRUE(bitwise_equal(linmath::parse_text<double>(os.str()), matr));
+
+  std::string path = ::testing::TempDir() + "test_io_matrix.csv";
+  linmath::save_text(path, matr, ',');
+  EXPECT_TRUE(bitwise_equal(linmath::load_text<double>(path), matr));
+  std::remove(path.c_str());
+  EXPECT_THROW(linmath::load_text<double>(path), std::runtime_error);
+}
+
+int main(int argc, char* argv[]) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
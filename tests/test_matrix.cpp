@@ -3,6 +3,59 @@
 #include <iostream>
 #include "matrix.hpp"
 
+TEST(test_matrix, test_pow) {
+  linmath::matrix<long long> fib{2, 2, {1, 1, 1, 0}};
+  auto res = fib.pow(10);
+  ASSERT_EQ(res[0][0], 89);
+  ASSERT_EQ(res[0][1], 55);
+  ASSERT_EQ(fib.pow_mod(10, 7)[0][1], 55 % 7);
+}
+
+TEST(test_matrix, test_transform) {
+  linmath::matrix<int> a{2, 2, {1, 2, 3, 4}};
+  linmath::matrix<int> b{2, 2, {4, 3, 2, 1}};
+  auto sum = a.zip_with([](int x, int y) { return x + y; }, b);
+  ASSERT_EQ(sum[1][0], 5);
+  a.apply_inplace([](int x) { return x * x; });
+  ASSERT_EQ(a[1][1], 16);
+  ASSERT_EQ(a.transform([](int x) { return -x; })[0][1], -4);
+}
+
+TEST(test_matrix, test_copy_move) {
+  linmath::matrix<int> a{2, 2, {1, 2, 3, 4}};
+  linmath::matrix<int> b{a};
+  b[0][0] = 9;
+  ASSERT_EQ(a[0][0], 1);
+
+  linmath::matrix<int> c{std::move(b)};
+  ASSERT_EQ(c[0][0], 9);
+  ASSERT_EQ(c[1][1], 4);
+  a = c;
+  c[1][0] = 0;
+  ASSERT_EQ(a[1][0], 3);
+}
+
+TEST(test_matrix, test_compound_ops) {
+  linmath::matrix<int> a{2, 2, {1, 2, 3, 4}};
+  linmath::matrix<int> b{2, 2, {0, 1, 1, 0}};
+  a *= b;
+  ASSERT_EQ(a[0][0], 2);
+  ASSERT_EQ(a[1][0], 4);
+  a += b;
+  ASSERT_EQ(a[0][1], 2);
+  a -= b;
+  a *= 3;
+  ASSERT_EQ(a[1][1], 9);
+  a /= 3;
+  ASSERT_EQ(a[1][0], 4);
+
+  // heap-stored matrices take the same path
+  linmath::matrix<double> c{20, 20, 1.0};
+  linmath::matrix<double> d{20, 30, 2.0};
+  c *= d;
+  ASSERT_EQ(c.ncols(), 30);
+  ASSERT_EQ(c[19][29], 40.0);
+}
 
 int main(int argc, char* argv[]) {
   ::testing::InitGoogleTest(&argc, argv);
@@ -0,0 +1,70 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <utility>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "kernels.hpp"
+#include "parallel.hpp"
+
+TEST(test_parallel, test_chunks) {
+  std::vector<int> hits(1000, 0);
+  parallel::for_each_chunk(hits.size(), 10, [&](std::size_t b, std::size_t e) {
+    for (std::size_t i = b; i != e; ++i)
+      ++hits[i];
+  });
+  for (int h : hits)
+    ASSERT_EQ(h, 1);
+}
+
+TEST(test_parallel, test_exception) {
+  auto fn = [](std::size_t b, std::size_t) {
+    if (b == 0)
+      throw std::runtime_error("chunk");
+  };
+  EXPECT_THROW(parallel::for_each_chunk(1000, 1, fn), std::runtime_error);
+}
+
+TEST(test_parallel, test_submit_to) {
+  parallel::thread_pool pool{3};
+  for (std::size_t w = 0; w != pool.size(); ++w) {
+    std::thread::id first = pool.submit_to(w, [] {
+      return std::this_thread::get_id();
+    }).get();
+    for (int rep = 0; rep != 20; ++rep)
+      ASSERT_EQ(pool.submit_to(w, [] { return std::this_thread::get_id(); })
+                    .get(),
+                first);
+  }
+}
+
+TEST(test_parallel, test_row_partition) {
+  // fill and gemm of the same matrix must split its rows identically
+  parallel::thread_pool pool{4};
+  parallel::pool_scope scope{pool};
+  auto chunks = [](std::size_t row_work, std::size_t threshold) {
+    std::vector<std::pair<std::size_t, std::size_t>> ret;
+    std::mutex mutex;
+    linmath::kernels::detail::split_rows(
+        700, row_work,
+        [&](std::size_t b, std::size_t e) {
+          std::lock_guard<std::mutex> lock{mutex};
+          ret.emplace_back(b, e);
+        },
+        threshold);
+    std::sort(ret.begin(), ret.end());
+    return ret;
+  };
+  auto& params = linmath::kernels::params();
+  auto fill = chunks(700, params.fill_parallel_threshold);
+  auto gemm = chunks(700 * 700, params.gemm_parallel_threshold);
+  ASSERT_GT(fill.size(), 1);
+  ASSERT_TRUE(fill == gemm);
+}
+
+int main(int argc, char* argv[]) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,177 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include "quantized.hpp"
+
+using f_matrix = typename linmath::shell_matrix<float>;
+
+static f_matrix random_matrix(std::size_t rows, std::size_t cols,
+                              unsigned seed) {
+  std::srand(seed);
+  f_matrix ret{rows, cols};
+  for (std::size_t i = 0; i < rows; ++i)
+    for (std::size_t j = 0; j < cols; ++j)
+      ret[i][j] = static_cast<float>(std::rand()) / RAND_MAX * 4 - 2;
+  return ret;
+}
+
+template <typename Q>
+static linmath::shell_matrix<Q> random_quantized(std::size_t rows,
+                                                 std::size_t cols,
+                                                 unsigned seed) {
+  std::srand(seed);
+  const int qmax = std::numeric_limits<Q>::max();
+  linmath::shell_matrix<Q> ret{rows, cols};
+  for (std::size_t i = 0; i < rows; ++i)
+    for (std::size_t j = 0; j < cols; ++j)
+      ret[i][j] = static_cast<Q>(std::rand() % (2 * qmax + 1) - qmax);
+  return ret;
+}
+
+template <typename Q>
+static void check_kernels(std::size_t n, std::size_t k, std::size_t m) {
+  auto a = random_quantized<Q>(n, k, 1);
+  auto b = random_quantized<Q>(k, m, 2);
+  linmath::shell_matrix<Q> bt{m, k};
+  for (std::size_t p = 0; p < k; ++p)
+    for (std::size_t j = 0; j < m; ++j)
+      bt[j][p] = b[p][j];
+
+  using acc_t = linmath::accumulator_t<Q>;
+  linmath::shell_matrix<acc_t> expected{n, m};
+  for (std::size_t i = 0; i < n; ++i)
+    for (std::size_t j = 0; j < m; ++j)
+      for (std::size_t p = 0; p < k; ++p)
+        expected[i][j] += static_cast<acc_t>(a[i][p]) * b[p][j];
+
+  for (auto level : {simd::isa::scalar, simd::isa::avx2,
+                     simd::isa::avx512_vnni}) {
+    if (!simd::supports(level))
+      continue;
+    linmath::shell_matrix<acc_t> res{n, m};
+    linmath::kernels::gemm_quantized(a.data(), bt.data(), res.data(), n, k,
+                                     m, level);
+    EXPECT_TRUE(res == expected) << "isa " << static_cast<int>(level);
+  }
+  EXPECT_TRUE(linmath::multiply_raw(a, b) == expected);
+}
+
+TEST(test_quantized, test_roundtrip) {
+  f_matrix a = random_matrix(7, 9, 3);
+  for (auto axis : {linmath::quant_axis::rows, linmath::quant_axis::cols}) {
+    auto q = linmath::quantize<std::int8_t>(a, axis);
+    f_matrix back = linmath::dequantize(q);
+    for (std::size_t i = 0; i < 7; ++i)
+      for (std::size_t j = 0; j < 9; ++j) {
+        float s = q.scales[axis == linmath::quant_axis::rows ? i : j];
+        EXPECT_LE(std::abs(back[i][j] - a[i][j]), s / 2 + 1e-6f);
+        EXPECT_GE(q.values[i][j], -127);
+      }
+  }
+}
+
+TEST(test_quantized, test_zero_row) {
+  f_matrix a{2, 3, {0, 0, 0, 1, -2, 3}};
+  auto q = linmath::quantize<std::int8_t>(a);
+  EXPECT_EQ(q.scales[0], 1.0f);
+  EXPECT_FLOAT_EQ(q.scales[1], 3.0f / 127);
+  f_matrix back = linmath::dequantize(q);
+  for (std::size_t j = 0; j < 3; ++j) {
+    EXPECT_EQ(back[0][j], 0.0f);
+    EXPECT_NEAR(back[1][j], a[1][j], q.scales[1] / 2);
+  }
+}
+
+TEST(test_quantized, test_kernels_s8) {
+  check_kernels<std::int8_t>(13, 101, 17);
+  check_kernels<std::int8_t>(3, 32, 5);
+  check_kernels<std::int8_t>(70, 300, 66);
+}
+
+TEST(test_quantized, test_kernels_s16) {
+  check_kernels<std::int16_t>(13, 37, 17);
+  check_kernels<std::int16_t>(9, 16, 4);
+}
+
+template <typename Q>
+static void check_edge_values() {
+  // rows of +-max in every sign combination stress the widest pair sums
+  const std::size_t n = 4, k = 70, m = 4;
+  const Q qmax = std::numeric_limits<Q>::max();
+  linmath::shell_matrix<Q> a{n, k};
+  linmath::shell_matrix<Q> bt{m, k};
+  for (std::size_t p = 0; p < k; ++p)
+    for (std::size_t i = 0; i < n; ++i) {
+      a[i][p] = static_cast<Q>(((i + p) % 2 ? -1 : 1) * qmax);
+      bt[i][p] = static_cast<Q>((i / 2 + p) % 3 ? -qmax : qmax);
+    }
+
+  using acc_t = linmath::accumulator_t<Q>;
+  linmath::shell_matrix<acc_t> expected{n, m};
+  for (std::size_t i = 0; i < n; ++i)
+    for (std::size_t j = 0; j < m; ++j)
+      for (std::size_t p = 0; p < k; ++p)
+        expected[i][j] += static_cast<acc_t>(a[i][p]) * bt[j][p];
+
+  for (auto level : {simd::isa::scalar, simd::isa::avx2,
+                     simd::isa::avx512_vnni}) {
+    if (!simd::supports(level))
+      continue;
+    linmath::shell_matrix<acc_t> res{n, m};
+    linmath::kernels::gemm_quantized(a.data(), bt.data(), res.data(), n, k,
+                                     m, level);
+    EXPECT_TRUE(res == expected) << "isa " << static_cast<int>(level);
+
+    // the minimum of Q is rejected on either side, whatever the ISA
+    linmath::shell_matrix<Q> bad_a{a};
+    bad_a[1][33] = std::numeric_limits<Q>::min();
+    linmath::shell_matrix<Q> bad_b{bt};
+    bad_b[2][64] = std::numeric_limits<Q>::min();
+    EXPECT_THROW(linmath::kernels::gemm_quantized(
+                     bad_a.data(), bt.data(), res.data(), n, k, m, level),
+                 std::invalid_argument);
+    EXPECT_THROW(linmath::kernels::gemm_quantized(
+                     a.data(), bad_b.data(), res.data(), n, k, m, level),
+                 std::invalid_argument);
+  }
+
+  linmath::shell_matrix<Q> b{k, m, qmax};
+  b[5][1] = std::numeric_limits<Q>::min();
+  EXPECT_THROW(linmath::multiply_raw(a, b), std::invalid_argument);
+}
+
+TEST(test_quantized, test_edge_values) {
+  check_edge_values<std::int8_t>();
+  check_edge_values<std::int16_t>();
+}
+
+TEST(test_quantized, test_error_against_float) {
+  const std::size_t n = 24, k = 200, m = 18;
+  f_matrix a = random_matrix(n, k, 5);
+  f_matrix b = random_matrix(k, m, 6);
+  f_matrix exact = a * b;
+
+  auto check = [&](const f_matrix& approx, float rel) {
+    double err = 0, norm = 0;
+    for (std::size_t i = 0; i < n; ++i)
+      for (std::size_t j = 0; j < m; ++j) {
+        err += std::pow(approx[i][j] - exact[i][j], 2);
+        norm += std::pow(exact[i][j], 2);
+      }
+    EXPECT_LE(std::sqrt(err / norm), rel);
+  };
+  check(linmath::quantized_multiply<std::int8_t>(a, b), 2e-2f);
+  check(linmath::quantized_multiply<std::int16_t>(a, b), 1e-4f);
+
+  auto qa = linmath::quantize<std::int8_t>(a, linmath::quant_axis::cols);
+  auto qb = linmath::quantize<std::int8_t>(b, linmath::quant_axis::cols);
+  EXPECT_THROW(linmath::multiply(qa, qb), std::invalid_argument);
+}
+
+int main(int argc, char* argv[]) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -1,6 +1,9 @@
 #include <gtest/gtest.h>
 #include <cstdlib>
 #include <iostream>
+#include <memory>
+#include <ranges>
+#include <vector>
 #include "shell_matrix.hpp"
 
 using sh_matrix = typename linmath::shell_matrix<float>;
@@ -116,6 +119,199 @@ TEST(test_shell_matrix, test_multiplication_3) {
   ASSERT_TRUE(A != C);
 }
 
+TEST(test_shell_matrix, test_pow) {
+  sh_matrix A{3, 3, {0.5, 1, 0, 0, 0.5, 1, 1, 0, 0.5}};
+  sh_matrix expected = sh_matrix::identity(3);
+  for (int i = 0; i < 11; ++i)
+    expected = expected * A;
+
+  ASSERT_TRUE(A.pow(11) == expected);
+  ASSERT_TRUE(A.pow(1) == A);
+  ASSERT_TRUE(A.pow(0) == sh_matrix::identity(3));
+  EXPECT_THROW(sh_matrix(2, 3).pow(2), std::runtime_error);
+}
+
+TEST(test_shell_matrix, test_pow_mod) {
+  using int_matrix = linmath::shell_matrix<long long>;
+  const std::uint64_t mod = 1000000007;
+
+  int_matrix fib{2, 2, {1, 1, 1, 0}};
+  ASSERT_EQ(fib.pow(90)[0][1], 2880067194370816120LL);
+  ASSERT_EQ(fib.pow_mod(90, mod)[0][1], 2880067194370816120LL % mod);
+
+  // fast doubling as an independent reference for F(10^18) mod p
+  auto fib_mod = [mod](std::uint64_t n) {
+    std::uint64_t a = 0, b = 1;
+    for (int bit = 63; bit >= 0; --bit) {
+      std::uint64_t c = a * ((2 * b + mod - a) % mod) % mod;
+      std::uint64_t d = (a * a + b * b) % mod;
+      a = c;
+      b = d;
+      if ((n >> bit) & 1) {
+        a = d;
+        b = (c + d) % mod;
+      }
+    }
+    return a;
+  };
+  const std::uint64_t k = 1000000000000000000ULL;
+  ASSERT_EQ(static_cast<std::uint64_t>(fib.pow_mod(k, mod)[0][1]), fib_mod(k));
+
+  int_matrix neg{2, 2, {-1, 0, 0, -1}};
+  ASSERT_TRUE(neg.pow_mod(3, 7) == int_matrix(2, 2, {6, 0, 0, 6}));
+  EXPECT_THROW(fib.pow_mod(2, 0), std::invalid_argument);
+
+  // 40 columns span several unreduced runs for every modulus but the last
+  const std::size_t n = 40;
+  for (std::uint64_t m : {97ULL, 1000000007ULL, 4294967291ULL}) {
+    int_matrix a{n, n};
+    std::uint64_t state = m;
+    for (std::size_t i = 0; i < n; ++i)
+      for (std::size_t j = 0; j < n; ++j) {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        a[i][j] = static_cast<long long>(state >> 20) - (1LL << 43);
+      }
+    int_matrix base{n, n}, ref{int_matrix::identity(n)};
+    for (std::size_t i = 0; i < n; ++i)
+      for (std::size_t j = 0; j < n; ++j)
+        base[i][j] = ((a[i][j] % static_cast<long long>(m)) + m) % m;
+    for (int step = 0; step < 5; ++step) {
+      int_matrix next{n, n};
+      for (std::size_t i = 0; i < n; ++i)
+        for (std::size_t j = 0; j < n; ++j) {
+          unsigned __int128 acc = 0;
+          for (std::size_t p = 0; p < n; ++p)
+            acc += static_cast<unsigned __int128>(ref[i][p]) * base[p][j];
+          next[i][j] = static_cast<long long>(acc % m);
+        }
+      ref = next;
+    }
+    ASSERT_TRUE(a.pow_mod(5, m) == ref) << m;
+  }
+}
+
+// Keeps its value on the heap and counts live objects, so elements that
+// get overwritten without being destroyed show up as leaks
+struct boxed {
+  static inline int live = 0;
+  std::unique_ptr<long> val;
+
+  boxed(long v = 0) : val{std::make_unique<long>(v)} { ++live; }
+  boxed(const boxed& rhs) : boxed{*rhs.val} {}
+  boxed& operator=(const boxed& rhs) {
+    *val = *rhs.val;
+    return *this;
+  }
+  ~boxed() { --live; }
+
+  boxed& operator+=(const boxed& rhs) {
+    *val += *rhs.val;
+    return *this;
+  }
+  friend boxed operator*(const boxed& lhs, const boxed& rhs) {
+    return *lhs.val * *rhs.val;
+  }
+};
+
+TEST(test_shell_matrix, test_pow_owning) {
+  {
+    linmath::shell_matrix<boxed> fib{2, 2};
+    fib[0][0] = 1;
+    fib[0][1] = 1;
+    fib[1][0] = 1;
+    auto res = fib.pow(10);
+    EXPECT_EQ(*res[0][0].val, 89);
+    EXPECT_EQ(*res[0][1].val, 55);
+    EXPECT_EQ(*res[1][1].val, 34);
+  }
+  EXPECT_EQ(boxed::live, 0);
+}
+
+TEST(test_shell_matrix, test_large_init) {
+  const std::size_t n = 700;
+  sh_matrix A{n, n, 2.5f};
+  const float* frst = A.data();
+  ASSERT_TRUE(std::all_of(frst, frst + n * n, [](float x) { return x == 2.5f; }));
+
+  sh_matrix B{A};
+  B[n - 1][n - 1] = 0;
+  ASSERT_EQ(A[n - 1][n - 1], 2.5f);
+  B = A;
+  ASSERT_TRUE(B == A);
+
+  sh_matrix I = sh_matrix::identity(n);
+  float sum = 0;
+  for (float x : I)
+    sum += x;
+  ASSERT_EQ(sum, float(n));
+  ASSERT_EQ(I.trace(), float(n));
+
+  sh_matrix U{3, 4, containers::uninitialized};
+  ASSERT_EQ(U.nrows(), 3);
+  ASSERT_EQ(U.ncols(), 4);
+}
+
+TEST(test_shell_matrix, test_transform) {
+  sh_matrix A{2, 3, {-1, 2, -3, 4, -5, 6}};
+  sh_matrix B{2, 3, {1, 1, 1, 2, 2, 2}};
+  sh_matrix C{2, 3, {0, 1, 0, 1, 0, 1}};
+
+  auto relu = [](float x) { return x > 0 ? x : 0; };
+  ASSERT_TRUE(A.transform(relu) == sh_matrix(2, 3, {0, 2, 0, 4, 0, 6}));
+  ASSERT_TRUE(A.zip_with([](float a, float b) { return a * b; }, B) ==
+              sh_matrix(2, 3, {-1, 2, -3, 8, -10, 12}));
+  ASSERT_TRUE(A.zip_with([](float a, float b, float c) { return a * b + c; },
+                         B, C) == sh_matrix(2, 3, {-1, 3, -3, 9, -10, 13}));
+
+  sh_matrix Y{B};
+  Y.apply_inplace([](float y, float x) { return 2 * x + y; }, A);
+  ASSERT_TRUE(Y == sh_matrix(2, 3, {-1, 5, -5, 10, -8, 14}));
+  Y.apply_inplace([](float y) { return -y; });
+  ASSERT_EQ(Y[1][2], -14);
+
+  EXPECT_THROW(A.zip_with([](float a, float b) { return a + b; },
+                          sh_matrix{3, 2}),
+               std::runtime_error);
+}
+
+TEST(test_shell_matrix, test_transform_large) {
+  const std::size_t n = 500;
+  sh_matrix X{n, n, 3.0f};
+  sh_matrix Y{n, n, 1.0f};
+  Y.apply_inplace([](float y, float x) { return 0.5f * x + y; }, X);
+  sh_matrix Z = Y.zip_with([](float y, float x) { return y - x; }, X);
+  const float* frst = Z.data();
+  ASSERT_TRUE(std::all_of(frst, frst + n * n, [](float x) { return x == -0.5f; }));
+}
+
+static_assert(std::contiguous_iterator<it>);
+static_assert(std::ranges::contiguous_range<sh_matrix>);
+static_assert(std::ranges::contiguous_range<containers::vector<float>>);
+static_assert(std::random_access_iterator<iterator::strided_iterator<float>>);
+
+TEST(test_shell_matrix, test_ranges) {
+  sh_matrix a{3, 4, {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12}};
+
+  ASSERT_EQ(std::ranges::distance(a), 12);
+  ASSERT_EQ(std::ranges::max(a.row_span(1)), 8);
+  ASSERT_TRUE(std::ranges::equal(a.column(2), std::vector<float>{3, 7, 11}));
+  ASSERT_TRUE(std::ranges::equal(a.diagonal(), std::vector<float>{1, 6, 11}));
+
+  float sum = 0;
+  for (auto row : a.rows())
+    sum += row.back();
+  ASSERT_EQ(sum, 24);
+
+  std::ranges::fill(a.column(0), 0.0f);
+  std::ranges::reverse(a.diagonal());
+  ASSERT_TRUE(a == sh_matrix(3, 4, {11, 2, 3, 4, 0, 6, 7, 8, 0, 10, 0, 12}));
+
+  const sh_matrix& c = a;
+  ASSERT_EQ(*std::ranges::min_element(c.column(3)), 4);
+  std::sort(a.begin(), a.end());
+  ASSERT_TRUE(std::ranges::is_sorted(a));
+}
+
 int main(int argc, char* argv[]) {
   ::testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
@@ -0,0 +1,134 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include "structured.hpp"
+
+using sh_matrix = typename linmath::shell_matrix<double>;
+using vec = containers::vector<double>;
+
+static sh_matrix random_banded(std::size_t sz, std::size_t kl, std::size_t ku,
+                               unsigned seed) {
+  std::srand(seed);
+  sh_matrix ret{sz, sz};
+  for (std::size_t i = 0; i < sz; ++i)
+    for (std::size_t j = 0; j < sz; ++j)
+      if (j + kl >= i && j <= i + ku)
+        ret[i][j] = static_cast<double>(std::rand()) / RAND_MAX - 0.5;
+  return ret;
+}
+
+static vec random_vector(std::size_t sz) {
+  vec ret(sz);
+  for (std::size_t i = 0; i < sz; ++i)
+    ret[i] = static_cast<double>(std::rand()) / RAND_MAX - 0.5;
+  return ret;
+}
+
+static vec dense_multiply(const sh_matrix& a, const vec& x) {
+  vec ret(a.nrows());
+  for (std::size_t i = 0; i < a.nrows(); ++i)
+    for (std::size_t j = 0; j < a.ncols(); ++j)
+      ret[i] += a[i][j] * x[j];
+  return ret;
+}
+
+TEST(test_structured, test_band_multiply) {
+  const std::size_t sz = 40;
+  sh_matrix dense = random_banded(sz, 2, 3, 7);
+  auto band = linmath::band_matrix<double>::from_dense(dense, 2, 3);
+  ASSERT_TRUE(band.to_dense() == dense);
+  ASSERT_EQ(band(0, 5), 0.0);
+  EXPECT_THROW(band.at(10, 0), std::out_of_range);
+
+  vec x = random_vector(sz);
+  vec y = band.multiply(x);
+  vec ref = dense_multiply(dense, x);
+  for (std::size_t i = 0; i < sz; ++i)
+    EXPECT_NEAR(y[i], ref[i], 1e-12);
+
+  sh_matrix b = random_banded(sz, sz, sz, 8);
+  ASSERT_TRUE(band.multiply(b) == dense * b);
+}
+
+TEST(test_structured, test_band_solve) {
+  const std::size_t sz = 60;
+  sh_matrix dense = random_banded(sz, 3, 1, 11);
+  // zero diagonal forces row swaps and U fill-in
+  for (std::size_t i = 0; i < sz; i += 2)
+    dense[i][i] = 0;
+  auto band = linmath::band_matrix<double>::from_dense(dense, 3, 1);
+
+  vec b = random_vector(sz);
+  vec x = band.solve(b);
+  vec r = dense_multiply(dense, x);
+  for (std::size_t i = 0; i < sz; ++i)
+    EXPECT_NEAR(r[i], b[i], 1e-9);
+
+  linmath::band_matrix<double> swap{2, 1, 1};
+  swap.at(0, 1) = 1;
+  swap.at(1, 0) = 1;
+  EXPECT_DOUBLE_EQ(swap.determinant(), -1);
+
+  linmath::band_matrix<double> singular{3, 1, 1};
+  EXPECT_EQ(singular.determinant(), 0);
+  EXPECT_THROW(singular.solve(vec(3)), std::runtime_error);
+}
+
+TEST(test_structured, test_tridiagonal) {
+  // 1D Laplacian: det = n + 1, exact in integers
+  const std::size_t sz = 50;
+  linmath::tridiagonal_matrix<long long> lap_int{sz, -1, 2, -1};
+  EXPECT_EQ(lap_int.determinant(), 51);
+
+  linmath::tridiagonal_matrix<double> lap{sz, -1, 2, -1};
+  EXPECT_NEAR(lap.to_band().determinant(), 51, 1e-9);
+  sh_matrix dense = lap.to_dense();
+  ASSERT_EQ(dense[3][4], -1);
+  ASSERT_EQ(dense[3][5], 0);
+
+  auto copy = linmath::tridiagonal_matrix<double>::from_dense(dense);
+  ASSERT_EQ(copy(7, 6), -1);
+  EXPECT_THROW(copy.at(7, 5), std::out_of_range);
+
+  vec b = random_vector(sz);
+  vec x = lap.solve(b);
+  vec r = lap.multiply(x);
+  vec r_dense = dense_multiply(dense, x);
+  for (std::size_t i = 0; i < sz; ++i) {
+    EXPECT_NEAR(r[i], b[i], 1e-9);
+    EXPECT_NEAR(r_dense[i], b[i], 1e-9);
+  }
+}
+
+TEST(test_structured, test_triangular) {
+  const std::size_t sz = 30;
+  for (auto kind : {linmath::triangle::lower, linmath::triangle::upper}) {
+    sh_matrix dense = kind == linmath::triangle::lower
+                          ? random_banded(sz, sz, 0, 3)
+                          : random_banded(sz, 0, sz, 3);
+    for (std::size_t i = 0; i < sz; ++i)
+      dense[i][i] += 2;
+    auto tri = linmath::triangular_matrix<double>::from_dense(dense, kind);
+    ASSERT_TRUE(tri.to_dense() == dense);
+
+    double det = 1;
+    for (std::size_t i = 0; i < sz; ++i)
+      det *= dense[i][i];
+    EXPECT_DOUBLE_EQ(tri.determinant(), det);
+
+    vec b = random_vector(sz);
+    vec x = tri.solve(b);
+    vec r = tri.multiply(x);
+    for (std::size_t i = 0; i < sz; ++i)
+      EXPECT_NEAR(r[i], b[i], 1e-9);
+
+    sh_matrix m = random_banded(sz, sz, sz, 4);
+    ASSERT_TRUE(tri.multiply(m) == dense * m);
+  }
+}
+
+int main(int argc, char* argv[]) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
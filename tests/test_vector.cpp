@@ -1,6 +1,7 @@
 #include <gtest/gtest.h>
 #include <cstdlib>
 #include <iostream>
+#include <string>
 #include "vector.hpp"
 
 static constexpr std::size_t default_capacity = 8;
@@ -82,6 +83,105 @@ TEST_F(VectorFixture, test_iterator) {
   }
 }
 
+// Points at itself, so a bitwise relocation would be visible
+struct self_ref {
+  self_ref* self = this;
+  int value = 0;
+
+  self_ref(int v) : value{v} {}
+  self_ref(const self_ref& rhs) : value{rhs.value} {}
+  self_ref(self_ref&& rhs) noexcept : value{rhs.value} {}
+  self_ref& operator=(const self_ref& rhs) {
+    value = rhs.value;
+    return *this;
+  }
+};
+
+static bool inside(const void* obj, std::size_t sz, const void* ptr) {
+  auto frst = static_cast<const char*>(obj);
+  auto p = static_cast<const char*>(ptr);
+  return p >= frst && p < frst + sz;
+}
+
+TEST(test_vector, test_small_buffer) {
+  vector my_vec;
+  for (int i = 0; i < 8; ++i)
+    my_vec.push_back(i);
+  ASSERT_TRUE(inside(&my_vec, sizeof(my_vec), my_vec.data()));
+
+  my_vec.push_back(8);
+  ASSERT_FALSE(inside(&my_vec, sizeof(my_vec), my_vec.data()));
+  ASSERT_EQ(my_vec.capacity(), 16);
+
+  my_vec.pop();
+  my_vec.pop();
+  my_vec.shrink_to_fit();
+  ASSERT_TRUE(inside(&my_vec, sizeof(my_vec), my_vec.data()));
+  for (int i = 0; i < 7; ++i)
+    ASSERT_EQ(my_vec[i], i);
+
+  vector moved{std::move(my_vec)};
+  ASSERT_EQ(moved.size(), 7);
+  ASSERT_EQ(moved.top(), 6);
+  ASSERT_TRUE(my_vec.empty());
+}
+
+TEST(test_vector, test_large_elements) {
+  // elements over 64 bytes get no inline storage at all
+  struct big {
+    char bytes[65];
+  };
+  using big_vector = containers::vector<big>;
+  ASSERT_EQ(sizeof(big_vector), 3 * sizeof(big*));
+
+  big_vector vec;
+  ASSERT_EQ(vec.capacity(), 0);
+  for (char i = 0; i < 3; ++i)
+    vec.push_back(big{{i}});
+  ASSERT_EQ(vec[2].bytes[0], 2);
+
+  big_vector moved{std::move(vec)};
+  ASSERT_TRUE(vec.empty());
+  ASSERT_EQ(moved.size(), 3);
+  big_vector copy{moved};
+  moved.shrink_to_fit();
+  ASSERT_EQ(copy[1].bytes[0], 1);
+}
+
+TEST(test_vector, test_emplace_back) {
+  containers::vector<std::string> strs;
+  for (int i = 0; i < 8; ++i)
+    strs.emplace_back(3, static_cast<char>('a' + i));
+  // argument refers into the vector while it grows
+  strs.emplace_back(strs[0]);
+  ASSERT_EQ(strs.size(), 9);
+  ASSERT_EQ(strs[8], "aaa");
+  ASSERT_EQ(strs[7], "hhh");
+
+  containers::vector<std::string> copy{strs};
+  containers::vector<std::string> small;
+  small.emplace_back("x");
+  small = std::move(copy);
+  ASSERT_EQ(small.size(), 9);
+  ASSERT_EQ(small[1], "bbb");
+}
+
+TEST(test_vector, test_relocation) {
+  static_assert(!containers::is_trivially_relocatable_v<self_ref>);
+  containers::vector<self_ref> refs;
+  for (int i = 0; i < 100; ++i) {
+    refs.emplace_back(i);
+    for (std::size_t j = 0; j < refs.size(); ++j)
+      ASSERT_EQ(refs[j].self, &refs[j]);
+  }
+  refs.shrink_to_fit();
+  ASSERT_EQ(refs.capacity(), 100);
+  for (std::size_t j = 0; j < refs.size(); ++j) {
+    ASSERT_EQ(refs[j].self, &refs[j]);
+    ASSERT_EQ(refs[j].value, j);
+  }
+}
+
 int main(int argc, char* argv[]) {
   ::testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();